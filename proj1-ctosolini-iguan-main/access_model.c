@@ -0,0 +1,236 @@
+#include "access_model.h"
+
+// Demand paging: while a process runs, it references pages according to an access model.
+// References to non-resident pages fault, and the fault is served through the frame manager,
+// using a free frame if there is one or evicting a victim chosen by the replacement policy.
+
+static int next_page(AccessModel* am, int process_index, int num_pages);
+static double next_random(AccessModel* am, int process_index);
+static int serve_page_fault(FrameManager* fm, ProcessManager* pm, Process* process, int page);
+static int compare_process_name(const void* a, const void* b);
+
+int parse_access_pattern(const char* name, AccessPattern* pattern) {
+
+    if (strcmp(name, "sequential") == 0) {
+        *pattern = ACCESS_SEQUENTIAL;
+    } else if (strcmp(name, "uniform") == 0) {
+        *pattern = ACCESS_UNIFORM;
+    } else if (strcmp(name, "zipf") == 0) {
+        *pattern = ACCESS_ZIPF;
+    } else {
+        return NOT_ALLOCATED;
+    }
+    return ALLOCATED;
+}
+
+void init_access_model(AccessModel* am, AccessPattern pattern, ProcessManager* pm, unsigned long long seed) {
+
+    am->pattern = pattern;
+    am->refs_per_quantum = DEFAULT_REFS_PER_QUANTUM;
+    am->fault_latency = DEFAULT_FAULT_LATENCY;
+    am->num_processes = pm->num_processes;
+    am->references = 0;
+    am->faults = 0;
+    am->traces = NULL;
+
+    am->rng_state = (unsigned long long*) malloc(pm->num_processes * sizeof(unsigned long long));
+    am->cursor = (int*) calloc(pm->num_processes, sizeof(int));
+    if ((!am->rng_state || !am->cursor) && pm->num_processes > 0) {
+        perror("Error: Could not allocate memory for the access model.");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < pm->num_processes; i++) {
+        am->rng_state[i] = seed * 0x9E3779B97F4A7C15ULL + i + 1;
+    }
+
+    am->harmonic[0] = 0;
+    for (int k = 1; k <= TOTAL_FRAMES; k++) {
+        am->harmonic[k] = am->harmonic[k - 1] + 1.0 / k;
+    }
+}
+
+// Trace file lines are "<process-name> <page>". A process missing from the file scans sequentially.
+void load_access_traces(AccessModel* am, ProcessManager* pm, char* filename) {
+
+    FILE* fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Could not open access trace %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    am->pattern = ACCESS_FILE;
+    am->traces = (AccessTrace*) calloc(pm->num_processes, sizeof(AccessTrace));
+
+    // Sort processes by name so each trace line is matched in O(log n)
+    Process** by_name = (Process**) malloc(pm->num_processes * sizeof(Process*));
+    if ((!am->traces || !by_name) && pm->num_processes > 0) {
+        perror("Error: Could not allocate memory for access traces.");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < pm->num_processes; i++) {
+        by_name[i] = &pm->processes[i];
+    }
+    qsort(by_name, pm->num_processes, sizeof(Process*), compare_process_name);
+
+    char name[MAX_PROCESS_NAME];
+    int page;
+    while (fscanf(fp, "%7s %d", name, &page) == 2) {
+        int lo = 0, hi = pm->num_processes - 1, found = NOT_IN_USE;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            int cmp = strcmp(name, by_name[mid]->name);
+            if (cmp == 0) {
+                found = by_name[mid] - pm->processes;
+                break;
+            }
+            if (cmp < 0) {
+                hi = mid - 1;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        if (found == NOT_IN_USE || page < 0) {
+            continue;
+        }
+
+        AccessTrace* trace = &am->traces[found];
+        if (trace->length == trace->capacity) {
+            trace->capacity = trace->capacity ? trace->capacity * 2 : INIT_CAPACITY;
+            int* temp_pages = (int*) realloc(trace->pages, trace->capacity * sizeof(int));
+            if (!temp_pages) {
+                perror("Error: Could not reallocate memory for an access trace.");
+                exit(EXIT_FAILURE);
+            }
+            trace->pages = temp_pages;
+        }
+        trace->pages[trace->length++] = page;
+    }
+
+    free(by_name);
+    fclose(fp);
+}
+
+// Generate this quantum's page references for the running process. Returns the number of faults.
+int simulate_page_accesses(FrameManager* fm, ProcessManager* pm, Process* process) {
+
+    AccessModel* am = fm->access_model;
+    int process_index = process - pm->processes;
+    int faults = 0;
+
+    for (int i = 0; i < am->refs_per_quantum; i++) {
+        int page = next_page(am, process_index, process->num_pages);
+        int frame_index = process->page_table[page];
+
+        if (frame_index == NOT_IN_USE) {
+            frame_index = serve_page_fault(fm, pm, process, page);
+            faults++;
+        }
+        touch_frame(fm, frame_index, pm->simulation_time);
+    }
+
+    am->references += am->refs_per_quantum;
+    am->faults += faults;
+    return faults;
+}
+
+void print_access_stats(AccessModel* am) {
+
+    double fault_rate = am->references ? (double) am->faults / am->references * 100 : 0;
+
+    printf("Page references %ld\n", am->references);
+    printf("Page faults %ld\n", am->faults);
+    printf("Fault rate %.2f%%\n", fault_rate);
+}
+
+void free_access_model(AccessModel* am) {
+
+    if (am->traces) {
+        for (int i = 0; i < am->num_processes; i++) {
+            free(am->traces[i].pages);
+        }
+        free(am->traces);
+    }
+    free(am->rng_state);
+    free(am->cursor);
+}
+
+static int next_page(AccessModel* am, int process_index, int num_pages) {
+
+    AccessTrace* trace;
+    double u;
+    int lo, hi;
+
+    switch (am->pattern) {
+        case ACCESS_UNIFORM:
+            return (int) (next_random(am, process_index) * num_pages);
+
+        case ACCESS_ZIPF:
+            // Invert the zipf (s = 1) CDF over the process's pages: smallest k with harmonic[k] >= u
+            u = next_random(am, process_index) * am->harmonic[num_pages];
+            lo = 1;
+            hi = num_pages;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (am->harmonic[mid] >= u) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+            return lo - 1;
+
+        case ACCESS_FILE:
+            trace = &am->traces[process_index];
+            if (trace->length > 0) {
+                int page = trace->pages[am->cursor[process_index]];
+                am->cursor[process_index] = (am->cursor[process_index] + 1) % trace->length;
+                return page % num_pages;
+            }
+            // No recorded trace, so a sequential scan
+            /* fallthrough */
+        case ACCESS_SEQUENTIAL:
+        default:
+            lo = am->cursor[process_index] % num_pages;
+            am->cursor[process_index] = (lo + 1) % num_pages;
+            return lo;
+    }
+}
+
+// splitmix64, returning a double in [0, 1)
+static double next_random(AccessModel* am, int process_index) {
+
+    unsigned long long z = (am->rng_state[process_index] += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int serve_page_fault(FrameManager* fm, ProcessManager* pm, Process* process, int page) {
+
+    int frame_index = NOT_IN_USE;
+
+    if (fm->frames_in_use < TOTAL_FRAMES) {
+        for (int i = 0; frame_index == NOT_IN_USE; i++) {
+            if (fm->frames[frame_in_order(fm, process, i)].is_allocated == NOT_ALLOCATED) {
+                frame_index = frame_in_order(fm, process, i);
+            }
+        }
+    } else {
+        frame_index = select_victim_frame(fm, pm, process);
+        if (frame_index == NOT_IN_USE) {
+            // Every resident frame is the process's own: replace its oldest loaded page
+            frame_index = process->frames[0];
+        }
+        evict_frame(fm, pm, frame_index);
+        print_evicted_frames(pm, &frame_index, 1);
+    }
+
+    load_page(fm, pm, process, page, frame_index);
+    return frame_index;
+}
+
+static int compare_process_name(const void* a, const void* b) {
+
+    return strcmp((*(Process* const*) a)->name, (*(Process* const*) b)->name);
+}
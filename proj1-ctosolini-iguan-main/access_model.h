@@ -0,0 +1,43 @@
+#ifndef ACCESS_MODEL_H
+#define ACCESS_MODEL_H
+#include "page_replacement.h"
+
+#define DEFAULT_REFS_PER_QUANTUM 4
+#define DEFAULT_FAULT_LATENCY 1 // simulated time charged per page fault
+#define DEFAULT_ACCESS_SEED 1
+
+typedef enum {
+    ACCESS_SEQUENTIAL,
+    ACCESS_UNIFORM,
+    ACCESS_ZIPF,
+    ACCESS_FILE
+} AccessPattern;
+
+// A recorded reference string for one process, replayed cyclically
+typedef struct {
+    int* pages;
+    int length;
+    int capacity;
+} AccessTrace;
+
+typedef struct AccessModel {
+    AccessPattern pattern;
+    int refs_per_quantum;
+    int fault_latency;
+    int num_processes;
+    unsigned long long* rng_state; // per process, so runs are reproducible for a given seed
+    int* cursor; // per process position in its sequential scan or recorded trace
+    AccessTrace* traces; // per process, ACCESS_FILE only
+    double harmonic[TOTAL_FRAMES + 1]; // zipf: harmonic[k] = 1 + 1/2 + ... + 1/k
+    long references;
+    long faults;
+} AccessModel;
+
+int parse_access_pattern(const char* name, AccessPattern* pattern);
+void init_access_model(AccessModel* am, AccessPattern pattern, ProcessManager* pm, unsigned long long seed);
+void load_access_traces(AccessModel* am, ProcessManager* pm, char* filename);
+int simulate_page_accesses(FrameManager* fm, ProcessManager* pm, Process* process);
+void print_access_stats(AccessModel* am);
+void free_access_model(AccessModel* am);
+
+#endif // ACCESS_MODEL_H
@@ -0,0 +1,276 @@
+#include "admission.h"
+
+// Orders two entries of one of the heaps below, true if a belongs above b
+typedef int (*HeapOrder)(AdmissionControl* ac, int a, int b);
+
+static void heap_swap(int* heap, int* heap_slot, int a, int b);
+static void sift_up(AdmissionControl* ac, int* heap, int* heap_slot, HeapOrder before, int slot);
+static void sift_down(AdmissionControl* ac, int* heap, int* heap_slot, int size, HeapOrder before, int slot);
+static void heap_remove(AdmissionControl* ac, int* heap, int* heap_slot, int* size, HeapOrder before, int slot);
+static int arrives_first(AdmissionControl* ac, int a, int b);
+static int finishes_first(AdmissionControl* ac, int a, int b);
+static int slot_finishes_first(AdmissionControl* ac, int a, int b);
+static void block(AdmissionControl* ac, int index);
+static void unblock(AdmissionControl* ac, int index);
+static void find_shadow(AdmissionControl* ac, MemoryManager* mm);
+
+
+int parse_admission_policy(const char* name, AdmissionPolicy* policy) {
+
+    if (strcmp(name, "reserve") == 0) {
+        *policy = ADMIT_RESERVE;
+    } else if (strcmp(name, "backfill") == 0) {
+        *policy = ADMIT_BACKFILL;
+    } else {
+        return NOT_ALLOCATED;
+    }
+    return ALLOCATED;
+}
+
+// Processes already holding memory, as after a restore, start out resident
+void init_admission(AdmissionControl* ac, AdmissionPolicy policy, ProcessManager* pm) {
+    int n = pm->num_processes;
+
+    memset(ac, 0, sizeof(AdmissionControl));
+    ac->policy = policy;
+    ac->processes = pm->processes;
+    ac->heap = malloc(n * sizeof(int));
+    ac->heap_slot = malloc(n * sizeof(int));
+    ac->resident = malloc(n * sizeof(int));
+    ac->resident_slot = malloc(n * sizeof(int));
+    ac->frontier = malloc(n * sizeof(int));
+    if ((!ac->heap || !ac->heap_slot || !ac->resident || !ac->resident_slot || !ac->frontier) && n > 0) {
+        perror("Error: Failed to allocate memory for admission control");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        ac->heap_slot[i] = NOT_BLOCKED;
+        ac->resident_slot[i] = NOT_BLOCKED;
+        if (pm->processes[i].memory_allocated && pm->processes[i].status != FINISHED) {
+            ac->resident_slot[i] = ac->num_resident;
+            ac->resident[ac->num_resident++] = i;
+            sift_up(ac, ac->resident, ac->resident_slot, finishes_first, ac->num_resident - 1);
+        }
+    }
+    ac->shadow = NO_SHADOW;
+    ac->stale = 1;
+}
+
+// Whether the process may try to allocate now. The oldest blocked process always may; under
+// reserve nobody else may while it waits, and under backfill another process may if it fits in
+// the memory the reservation will not need, or should finish before the memory for the
+// reservation frees up.
+int admit_process(AdmissionControl* ac, MemoryManager* mm, Process* process) {
+    int index = process - ac->processes;
+
+    if (ac->num_blocked == 0 || ac->heap[0] == index) {
+        return ALLOCATED;
+    }
+    if (ac->policy == ADMIT_BACKFILL) {
+        if (ac->stale) {
+            find_shadow(ac, mm);
+        }
+        if (process->memory_requirement <= ac->extra_kb) {
+            return ALLOCATED;
+        }
+        if (ac->shadow != NO_SHADOW &&
+                process->remaining_time <= ac->processes[ac->shadow].remaining_time) {
+            return ALLOCATED;
+        }
+    }
+    ac->refused++;
+    return NOT_ALLOCATED;
+}
+
+// Track the outcome of an allocation attempt, refused ones included
+void record_admission(AdmissionControl* ac, Process* process, int allocated) {
+    int index = process - ac->processes;
+
+    if (!allocated) {
+        if (ac->heap_slot[index] == NOT_BLOCKED) {
+            block(ac, index);
+        }
+        return;
+    }
+    if (ac->num_blocked > 0 && ac->heap[0] < index) {
+        ac->backfilled++;
+    }
+    if (ac->heap_slot[index] != NOT_BLOCKED) {
+        unblock(ac, index);
+    }
+    ac->resident_slot[index] = ac->num_resident;
+    ac->resident[ac->num_resident++] = index;
+    sift_up(ac, ac->resident, ac->resident_slot, finishes_first, ac->num_resident - 1);
+    ac->stale = 1;
+}
+
+// A resident process has run, so it may now finish ahead of others
+void record_progress(AdmissionControl* ac, Process* process) {
+    int slot = ac->resident_slot[process - ac->processes];
+
+    if (slot != NOT_BLOCKED) {
+        sift_up(ac, ac->resident, ac->resident_slot, finishes_first, slot);
+    }
+}
+
+void release_admitted(AdmissionControl* ac, Process* process) {
+    int index = process - ac->processes;
+    int slot = ac->resident_slot[index];
+
+    if (slot == NOT_BLOCKED) {
+        return;
+    }
+    heap_remove(ac, ac->resident, ac->resident_slot, &ac->num_resident, finishes_first, slot);
+    ac->stale = 1;
+}
+
+void print_admission_stats(AdmissionControl* ac) {
+
+    printf("Admission blocked %ld\n", ac->blocked);
+    printf("Admission refused %ld\n", ac->refused);
+    if (ac->policy == ADMIT_BACKFILL) {
+        printf("Admission backfilled %ld\n", ac->backfilled);
+    }
+}
+
+void free_admission(AdmissionControl* ac) {
+
+    free(ac->heap);
+    free(ac->heap_slot);
+    free(ac->resident);
+    free(ac->resident_slot);
+    free(ac->frontier);
+}
+
+
+// heap_slot, if not NULL, tracks where each entry is
+static void heap_swap(int* heap, int* heap_slot, int a, int b) {
+    int tmp = heap[a];
+
+    heap[a] = heap[b];
+    heap[b] = tmp;
+    if (heap_slot) {
+        heap_slot[heap[a]] = a;
+        heap_slot[heap[b]] = b;
+    }
+}
+
+static void sift_up(AdmissionControl* ac, int* heap, int* heap_slot, HeapOrder before, int slot) {
+
+    while (slot > 0 && before(ac, heap[slot], heap[(slot - 1) / 2])) {
+        heap_swap(heap, heap_slot, slot, (slot - 1) / 2);
+        slot = (slot - 1) / 2;
+    }
+}
+
+static void sift_down(AdmissionControl* ac, int* heap, int* heap_slot, int size, HeapOrder before, int slot) {
+
+    while (1) {
+        int first = slot;
+        int left = 2 * slot + 1;
+        int right = left + 1;
+        if (left < size && before(ac, heap[left], heap[first])) {
+            first = left;
+        }
+        if (right < size && before(ac, heap[right], heap[first])) {
+            first = right;
+        }
+        if (first == slot) {
+            return;
+        }
+        heap_swap(heap, heap_slot, slot, first);
+        slot = first;
+    }
+}
+
+static void heap_remove(AdmissionControl* ac, int* heap, int* heap_slot, int* size, HeapOrder before, int slot) {
+    int entry = heap[slot];
+
+    (*size)--;
+    if (slot != *size) {
+        heap_swap(heap, heap_slot, slot, *size);
+        sift_up(ac, heap, heap_slot, before, slot);
+        sift_down(ac, heap, heap_slot, *size, before, slot);
+    }
+    if (heap_slot) {
+        heap_slot[entry] = NOT_BLOCKED;
+    }
+}
+
+// Process indices follow arrival order, so the blocked heap is keyed on the index itself
+static int arrives_first(AdmissionControl* ac, int a, int b) {
+
+    return a < b;
+}
+
+// Shortest remaining time first, ties in arrival order
+static int finishes_first(AdmissionControl* ac, int a, int b) {
+    int remaining_a = ac->processes[a].remaining_time;
+    int remaining_b = ac->processes[b].remaining_time;
+
+    return remaining_a < remaining_b || (remaining_a == remaining_b && a < b);
+}
+
+// For the frontier, whose entries are slots in the resident heap
+static int slot_finishes_first(AdmissionControl* ac, int a, int b) {
+
+    return finishes_first(ac, ac->resident[a], ac->resident[b]);
+}
+
+static void block(AdmissionControl* ac, int index) {
+    int slot = ac->num_blocked++;
+
+    ac->heap[slot] = index;
+    ac->heap_slot[index] = slot;
+    sift_up(ac, ac->heap, ac->heap_slot, arrives_first, slot);
+    ac->blocked++;
+    if (ac->heap[0] == index) {
+        ac->stale = 1;
+    }
+}
+
+static void unblock(AdmissionControl* ac, int index) {
+    int slot = ac->heap_slot[index];
+
+    heap_remove(ac, ac->heap, ac->heap_slot, &ac->num_blocked, arrives_first, slot);
+    if (slot == 0) {
+        ac->stale = 1;
+    }
+}
+
+// Free memory is counted in KB, not holes, so a backfilled process may still take the hole the
+// reservation would have used; the reserved process then waits until the holes merge. The
+// resident processes are taken in order of finishing by walking down the resident heap, with the
+// frontier holding the slots reached but not yet taken, so only as many are looked at as it takes.
+static void find_shadow(AdmissionControl* ac, MemoryManager* mm) {
+    int required = ac->processes[ac->heap[0]].memory_requirement;
+    int free_kb = mm->mem_available;
+
+    ac->shadow = NO_SHADOW;
+    ac->extra_kb = free_kb - required;
+    ac->stale = 0;
+    if (free_kb >= required) {
+        return;
+    }
+
+    int num_frontier = 0;
+    if (ac->num_resident > 0) {
+        ac->frontier[num_frontier++] = 0;
+    }
+    while (num_frontier > 0) {
+        int slot = ac->frontier[0];
+        heap_remove(ac, ac->frontier, NULL, &num_frontier, slot_finishes_first, 0);
+
+        free_kb += ac->processes[ac->resident[slot]].memory_requirement;
+        if (free_kb >= required) {
+            ac->shadow = ac->resident[slot];
+            ac->extra_kb = free_kb - required;
+            return;
+        }
+        for (int child = 2 * slot + 1; child <= 2 * slot + 2 && child < ac->num_resident; child++) {
+            ac->frontier[num_frontier++] = child;
+            sift_up(ac, ac->frontier, NULL, slot_finishes_first, num_frontier - 1);
+        }
+    }
+    ac->extra_kb = 0;
+}
@@ -0,0 +1,48 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+#include "process.h"
+
+#define NOT_BLOCKED -1
+#define NO_SHADOW -1
+
+typedef enum {
+    ADMIT_ANY, // any process that fits gets memory, so a large one can wait behind smaller ones forever
+    ADMIT_RESERVE, // while the oldest blocked process waits, no other process gets memory
+    ADMIT_BACKFILL // others get memory only if that does not delay the oldest blocked process
+} AdmissionPolicy;
+
+// Admission control for first-fit. Processes that asked for memory and did not get it are kept in
+// a min-heap by arrival order; the one at the top holds a reservation on memory as it frees up.
+typedef struct AdmissionControl {
+    AdmissionPolicy policy;
+    Process* processes; // the process table, to turn processes into indices
+    int* heap; // blocked processes, oldest arrival at the top
+    int num_blocked;
+    int* heap_slot; // where each process is in the heap, or NOT_BLOCKED
+    int* resident; // processes holding memory, a min-heap by remaining time, ties in arrival order
+    int num_resident;
+    int* resident_slot; // where each process is in resident, or NOT_BLOCKED if it holds no memory
+
+    // The shadow point: the resident process whose completion frees enough memory for the
+    // reservation, assuming they finish in order of remaining time, and the KB free beyond the
+    // reservation at that point. Worked out again after memory changes hands.
+    int shadow;
+    int extra_kb;
+    int stale;
+    int* frontier; // scratch heap of slots in resident, for taking them in order
+
+    long blocked; // times a process joined the blocked heap
+    long refused; // allocations refused to protect the reservation
+    long backfilled; // processes given memory ahead of an older blocked process
+} AdmissionControl;
+
+int parse_admission_policy(const char* name, AdmissionPolicy* policy);
+void init_admission(AdmissionControl* ac, AdmissionPolicy policy, ProcessManager* pm);
+int admit_process(AdmissionControl* ac, MemoryManager* mm, Process* process);
+void record_admission(AdmissionControl* ac, Process* process, int allocated);
+void record_progress(AdmissionControl* ac, Process* process);
+void release_admitted(AdmissionControl* ac, Process* process);
+void print_admission_stats(AdmissionControl* ac);
+void free_admission(AdmissionControl* ac);
+
+#endif // ADMISSION_H
@@ -7,16 +7,104 @@
 #include "memory_allocation.h"
 #include "paged_allocation.h"
 #include "virtual_allocation.h"
+#include "page_replacement.h"
+#include "access_model.h"
+#include "checkpoint.h"
+#include "numa.h"
+#include "admission.h"
+#include "swap.h"
+#include "groups.h"
+#include "monitor.h"
+#include "multicore.h"
+#include "verify.h"
+#include "stats.h"
+
+// Long-only command line options
+enum {
+    OPT_REPLACE = 256,
+    OPT_WS_WINDOW,
+    OPT_ACCESS,
+    OPT_ACCESS_FILE,
+    OPT_REFS,
+    OPT_FAULT_LATENCY,
+    OPT_SEED,
+    OPT_COMPACT,
+    OPT_COMPACT_COST,
+    OPT_CHECKPOINT,
+    OPT_CHECKPOINT_AT,
+    OPT_CHECKPOINT_EVERY,
+    OPT_RESTORE,
+    OPT_BANKS,
+    OPT_PLACEMENT,
+    OPT_REMOTE_PENALTY,
+    OPT_MIGRATION_COST,
+    OPT_VERIFY,
+    OPT_PERCENTILES,
+    OPT_ADMISSION,
+    OPT_SUPERFRAME,
+    OPT_SWAP,
+    OPT_SWAP_BANDWIDTH,
+    OPT_SWAP_FULL,
+    OPT_MONITOR,
+    OPT_MONITOR_SOCKET,
+    OPT_MONITOR_INTERVAL,
+    NUM_OPTIONS
+};
+
+static struct option long_options[] = {
+    {"replace", required_argument, NULL, OPT_REPLACE},
+    {"ws-window", required_argument, NULL, OPT_WS_WINDOW},
+    {"access", required_argument, NULL, OPT_ACCESS},
+    {"access-file", required_argument, NULL, OPT_ACCESS_FILE},
+    {"refs", required_argument, NULL, OPT_REFS},
+    {"fault-latency", required_argument, NULL, OPT_FAULT_LATENCY},
+    {"seed", required_argument, NULL, OPT_SEED},
+    {"compact", required_argument, NULL, OPT_COMPACT},
+    {"compact-cost", required_argument, NULL, OPT_COMPACT_COST},
+    {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+    {"checkpoint-at", required_argument, NULL, OPT_CHECKPOINT_AT},
+    {"checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY},
+    {"restore", required_argument, NULL, OPT_RESTORE},
+    {"banks", required_argument, NULL, OPT_BANKS},
+    {"placement", required_argument, NULL, OPT_PLACEMENT},
+    {"remote-penalty", required_argument, NULL, OPT_REMOTE_PENALTY},
+    {"migration-cost", required_argument, NULL, OPT_MIGRATION_COST},
+    {"verify", no_argument, NULL, OPT_VERIFY},
+    {"percentiles", no_argument, NULL, OPT_PERCENTILES},
+    {"admission", required_argument, NULL, OPT_ADMISSION},
+    {"superframe", required_argument, NULL, OPT_SUPERFRAME},
+    {"swap", required_argument, NULL, OPT_SWAP},
+    {"swap-bandwidth", required_argument, NULL, OPT_SWAP_BANDWIDTH},
+    {"swap-full", required_argument, NULL, OPT_SWAP_FULL},
+    {"monitor", required_argument, NULL, OPT_MONITOR},
+    {"monitor-socket", required_argument, NULL, OPT_MONITOR_SOCKET},
+    {"monitor-interval", required_argument, NULL, OPT_MONITOR_INTERVAL},
+    {NULL, 0, NULL, 0}
+};
 
 void round_robin_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
+void reference_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
+void multicore_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs);
+int dispatch_cores(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs);
+int dispatch_batch(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs, int num_batch);
+int dispatch_core(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs, int c);
+void start_core(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs, int c);
 int allocate_memory(Process* process, ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
-void print_performance_stats(ProcessManager pm);
+int allocate_memory_batch(Process** processes, int n, ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
+void release_memory(Process** processes, int n, MemoryManager* mm, FrameManager* fm);
 int allocate_infinite(Process *process);
 int allocate_first_fit(MemoryManager *mm, Process *process);
-void free_memory(MemoryManager *mm, Process *process);
+int allocate_first_fit_range(MemoryManager *mm, Process *process, int lo, int hi);
+int allocate_first_fit_numa(MemoryManager *mm, ProcessManager *pm, Process *process);
+void free_memory_batch(MemoryManager *mm, Process **processes, int n);
 void load_processes(ProcessManager* pm);
-void execute_process(Process* process_to_run, ProcessManager *pm, MemoryManager *mm, FrameManager *fm);
-void print_process_status(MemoryStrategy strategy, ProcessManager *pm, Process *process_to_run, MemoryManager *mm, FrameManager *fm);
+int execute_process(Process* process_to_run, ProcessManager *pm, MemoryManager *mm, FrameManager *fm);
+void print_process_status(MemoryStrategy strategy, ProcessManager *pm, Process *process_to_run, MemoryManager *mm,
+    FrameManager *fm);
+int advance_rounds(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, int was_interrupted);
+int fast_forward_horizon(ProcessManager* pm);
+int skip_idle_time(ProcessManager* pm);
+void requeue_passed_over(ProcessManager* pm, int* passed_over, int* num_passed_over);
 
 int main (int argc, char* argv[]) {
     // hello
@@ -25,14 +113,53 @@ int main (int argc, char* argv[]) {
     Process* processes = NULL;
     int num_processes;
     MemoryStrategy memory_strategy = INFINITE; // Default memory strategy
-    int quantum; 
+    int quantum = 0; 
+    ReplacementPolicy replacement_policy = REPLACE_PROCESS;
+    int working_set_window = DEFAULT_WORKING_SET_WINDOW;
+    int simulate_accesses = 0;
+    AccessPattern access_pattern = ACCESS_SEQUENTIAL;
+    char* access_file = NULL;
+    int refs_per_quantum = DEFAULT_REFS_PER_QUANTUM;
+    int fault_latency = DEFAULT_FAULT_LATENCY;
+    unsigned long long seed = DEFAULT_ACCESS_SEED;
+    AccessModel access_model;
+    CompactionMode compaction = COMPACT_NONE;
+    double compaction_cost = DEFAULT_COMPACTION_COST;
+    char* checkpoint_path = NULL;
+    int checkpoint_at = NO_CHECKPOINT;
+    int checkpoint_every = 0;
+    char* restore_path = NULL;
+    int num_banks = 1;
+    PlacementPolicy placement = PLACE_LOCAL;
+    double remote_penalty = DEFAULT_REMOTE_PENALTY;
+    NumaModel numa;
+    int num_cores = 1;
+    int num_threads = AUTO_THREADS;
+    int migration_cost = DEFAULT_MIGRATION_COST;
+    CoreSet cores;
+    AdmissionPolicy admission_policy = ADMIT_ANY;
+    AdmissionControl admission;
+    int superframe_frames = BASE_FRAMES_ONLY;
+    int swap_kb = 0;
+    double swap_bandwidth = DEFAULT_SWAP_BANDWIDTH;
+    SwapFullPolicy swap_full_policy = SWAP_FULL_DISCARD;
+    SwapDevice swap;
+    TraceHeader trace = {0}; // memory groups live here, restored ones included
+    char* monitor_path = NULL;
+    char* monitor_socket = NULL;
+    int monitor_interval = DEFAULT_MONITOR_INTERVAL;
+    Monitor monitor;
+    int given[NUM_OPTIONS] = {0}; // which options appeared, so a restored run only overrides those
 
     // Parse command line arguments
     int opt;
-    while ((opt = getopt(argc, argv, "f:m:q:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "f:m:q:c:t:", long_options, NULL)) != -1) {
+        if (opt >= 0 && opt < NUM_OPTIONS) {
+            given[opt] = 1;
+        }
         switch (opt) {
             case 'f':
-                processes = init_processes(optarg, &num_processes);
+                processes = init_processes(optarg, &num_processes, &trace);
                 if (!processes) {
                     perror("Error: Failed to initialise processes\n");
                     exit(EXIT_FAILURE);
@@ -62,20 +189,454 @@ int main (int argc, char* argv[]) {
                     exit(EXIT_FAILURE);
                 }
                 break;
+
+            case 'c':
+                num_cores = atoi(optarg);
+                if (num_cores < 1) {
+                    fprintf(stderr, "Error: Invalid number of cores %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 't':
+                num_threads = atoi(optarg);
+                if (num_threads < 1) {
+                    fprintf(stderr, "Error: Invalid number of threads %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_REPLACE:
+                if (!parse_replacement_policy(optarg, &replacement_policy)) {
+                    fprintf(stderr, "Error: Invalid replacement policy %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_WS_WINDOW:
+                working_set_window = atoi(optarg);
+                if (working_set_window < 0) {
+                    fprintf(stderr, "Error: Invalid working-set window of %d\n", working_set_window);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_ACCESS:
+                if (!parse_access_pattern(optarg, &access_pattern)) {
+                    fprintf(stderr, "Error: Invalid access pattern %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                simulate_accesses = 1;
+                break;
+
+            case OPT_ACCESS_FILE:
+                access_file = optarg;
+                simulate_accesses = 1;
+                break;
+
+            case OPT_REFS:
+                refs_per_quantum = atoi(optarg);
+                if (refs_per_quantum < 1) {
+                    fprintf(stderr, "Error: Invalid number of page references per quantum %d\n", refs_per_quantum);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_FAULT_LATENCY:
+                fault_latency = atoi(optarg);
+                if (fault_latency < 0) {
+                    fprintf(stderr, "Error: Invalid page fault latency of %d\n", fault_latency);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_SEED:
+                seed = strtoull(optarg, NULL, 10);
+                break;
+
+            case OPT_COMPACT:
+                if (!parse_compaction_mode(optarg, &compaction)) {
+                    fprintf(stderr, "Error: Invalid compaction mode %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_COMPACT_COST:
+                compaction_cost = atof(optarg);
+                if (compaction_cost < 0) {
+                    fprintf(stderr, "Error: Invalid compaction cost of %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_CHECKPOINT:
+                checkpoint_path = optarg;
+                break;
+
+            case OPT_CHECKPOINT_AT:
+                checkpoint_at = atoi(optarg);
+                break;
+
+            case OPT_CHECKPOINT_EVERY:
+                checkpoint_every = atoi(optarg);
+                if (checkpoint_every < 1) {
+                    fprintf(stderr, "Error: Invalid checkpoint interval of %d\n", checkpoint_every);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_RESTORE:
+                restore_path = optarg;
+                break;
+
+            case OPT_BANKS:
+                num_banks = atoi(optarg);
+                if (num_banks < 1 || num_banks > MAX_BANKS || TOTAL_FRAMES % num_banks != 0) {
+                    fprintf(stderr, "Error: Invalid number of memory banks %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_PLACEMENT:
+                if (!parse_placement_policy(optarg, &placement)) {
+                    fprintf(stderr, "Error: Invalid placement policy %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_REMOTE_PENALTY:
+                remote_penalty = atof(optarg);
+                if (remote_penalty < 0) {
+                    fprintf(stderr, "Error: Invalid remote memory penalty of %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_MIGRATION_COST:
+                migration_cost = atoi(optarg);
+                if (migration_cost < 0) {
+                    fprintf(stderr, "Error: Invalid migration cost of %d\n", migration_cost);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_ADMISSION:
+                if (!parse_admission_policy(optarg, &admission_policy)) {
+                    fprintf(stderr, "Error: Invalid admission policy %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_SUPERFRAME:
+                if (!parse_superframe_size(optarg, &superframe_frames)) {
+                    fprintf(stderr, "Error: Invalid superframe size of %s frames\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_SWAP:
+                swap_kb = atoi(optarg);
+                if (swap_kb < 0) {
+                    fprintf(stderr, "Error: Invalid swap size of %dKB\n", swap_kb);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_SWAP_BANDWIDTH:
+                swap_bandwidth = atof(optarg);
+                if (swap_bandwidth <= 0) {
+                    fprintf(stderr, "Error: Invalid swap bandwidth of %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_SWAP_FULL:
+                if (!parse_swap_full_policy(optarg, &swap_full_policy)) {
+                    fprintf(stderr, "Error: Invalid swap-full policy %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_MONITOR:
+                monitor_path = optarg;
+                break;
+
+            case OPT_MONITOR_SOCKET:
+                monitor_socket = optarg;
+                break;
+
+            case OPT_MONITOR_INTERVAL:
+                monitor_interval = atoi(optarg);
+                if (monitor_interval < 1) {
+                    fprintf(stderr, "Error: Invalid monitor interval of %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case OPT_VERIFY:
+            case OPT_PERCENTILES:
+                break;
+
+            default:
+                exit(EXIT_FAILURE);
             }
         }
 
-    // Initialise the process manager
-    init_process_manager(&pm, num_processes, quantum);
-    pm.processes = processes;
+    // Snapshots are taken between steps of the single-core scheduler only
+    if (given['c'] && (given[OPT_CHECKPOINT] || restore_path)) {
+        fprintf(stderr, "Error: -c cannot be combined with --checkpoint or --restore\n");
+        exit(EXIT_FAILURE);
+    }
+    // Both engines run on one core from the start of the workload
+    if (given[OPT_VERIFY] && (given['c'] || given[OPT_CHECKPOINT] || restore_path)) {
+        fprintf(stderr, "Error: --verify cannot be combined with -c, --checkpoint or --restore\n");
+        exit(EXIT_FAILURE);
+    }
+    // The blocked processes are not part of a snapshot, though a restored run may start admission control afresh
+    if (given[OPT_ADMISSION] && given[OPT_CHECKPOINT]) {
+        fprintf(stderr, "Error: --admission cannot be combined with --checkpoint\n");
+        exit(EXIT_FAILURE);
+    }
+    // Pages on swap are not part of a snapshot
+    if ((given[OPT_SWAP] || given[OPT_SWAP_BANDWIDTH] || given[OPT_SWAP_FULL]) && (given[OPT_CHECKPOINT] || restore_path)) {
+        fprintf(stderr, "Error: --swap cannot be combined with --checkpoint or --restore\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((given[OPT_SWAP_BANDWIDTH] || given[OPT_SWAP_FULL]) && !given[OPT_SWAP]) {
+        fprintf(stderr, "Error: --swap-bandwidth and --swap-full need --swap\n");
+        exit(EXIT_FAILURE);
+    }
+    // The engines run in forked processes, which would both report to the same place
+    if ((monitor_path || monitor_socket) && given[OPT_VERIFY]) {
+        fprintf(stderr, "Error: --monitor and --monitor-socket cannot be combined with --verify\n");
+        exit(EXIT_FAILURE);
+    }
+    if (given[OPT_MONITOR_INTERVAL] && !monitor_path && !monitor_socket) {
+        fprintf(stderr, "Error: --monitor-interval needs a --monitor file or --monitor-socket\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!given['q'] && !restore_path) {
+        fprintf(stderr, "Error: A quantum must be given with -q\n");
+        exit(EXIT_FAILURE);
+    }
+    if (given['t'] && !given['c']) {
+        fprintf(stderr, "Error: -t needs -c\n");
+        exit(EXIT_FAILURE);
+    }
+    // Work stealing takes from the tail of a core's queue, which priorities would make the wrong end
+    if (trace.prioritised && (given['c'] || given[OPT_VERIFY])) {
+        fprintf(stderr, "Error: A trace with priorities cannot be combined with -c or --verify\n");
+        exit(EXIT_FAILURE);
+    }
+
     MemoryManager* mm = create_memory_manager();
     FrameManager fm;
-    init_frames(&fm);
-    mm = init_memory_manager(mm, memory_strategy);
-    
 
-    round_robin_scheduler(&pm, mm, &fm);
-    print_performance_stats(pm);
+    if (restore_path) {
+        // Resume from a snapshot. Settings that shape the saved state cannot change, but the
+        // rest may be overridden to fork what-if runs from a shared prefix.
+        if (given['m'] || given[OPT_REPLACE] || given[OPT_ACCESS] || given[OPT_ACCESS_FILE] || given[OPT_SEED] ||
+                given[OPT_BANKS] || given[OPT_PLACEMENT] || given[OPT_SUPERFRAME] || given[OPT_PERCENTILES]) {
+            fprintf(stderr, "Error: Memory strategy, replacement policy, access model, banks, superframes and percentiles come from the checkpoint\n");
+            exit(EXIT_FAILURE);
+        }
+        // Processes come from the checkpoint too
+        free(processes);
+
+        load_checkpoint(restore_path, &pm, mm, &fm, &access_model, &numa, &trace.groups);
+        memory_strategy = mm->strategy;
+        replacement_policy = fm.policy;
+        simulate_accesses = fm.access_model != NULL;
+        num_banks = fm.numa ? numa.num_banks : 1;
+
+        if (given['q']) {
+            pm.quantum = quantum;
+        }
+        if (given[OPT_WS_WINDOW]) {
+            fm.working_set_window = working_set_window;
+        }
+        if (given[OPT_REFS] && fm.access_model) {
+            access_model.refs_per_quantum = refs_per_quantum;
+        }
+        if (given[OPT_FAULT_LATENCY] && fm.access_model) {
+            access_model.fault_latency = fault_latency;
+        }
+        if (given[OPT_COMPACT]) {
+            mm->compaction = compaction;
+        }
+        if (given[OPT_COMPACT_COST]) {
+            mm->compaction_cost = compaction_cost;
+        }
+        compaction = mm->compaction;
+        if (given[OPT_REMOTE_PENALTY] && fm.numa) {
+            numa.remote_penalty = remote_penalty;
+        }
+    }
+
+    if ((replacement_policy != REPLACE_PROCESS || simulate_accesses) && memory_strategy != VIRTUAL) {
+        fprintf(stderr, "Error: --replace and --access are only supported with -m virtual\n");
+        exit(EXIT_FAILURE);
+    }
+    if (given[OPT_SWAP] && memory_strategy != VIRTUAL) {
+        fprintf(stderr, "Error: --swap is only supported with -m virtual\n");
+        exit(EXIT_FAILURE);
+    }
+    if (compaction != COMPACT_NONE && memory_strategy != FIRST_FIT) {
+        fprintf(stderr, "Error: --compact is only supported with -m first-fit\n");
+        exit(EXIT_FAILURE);
+    }
+    // Superframes need aligned runs of frames, which bank frame orders do not keep together
+    if (superframe_frames != BASE_FRAMES_ONLY && (memory_strategy != PAGED || num_banks > 1)) {
+        fprintf(stderr, "Error: --superframe is only supported with -m paged, without --banks\n");
+        exit(EXIT_FAILURE);
+    }
+    // Pages come and go one at a time in virtual mode, and infinite memory has no quota to keep
+    if (trace.groups.num_groups > 0 && memory_strategy == VIRTUAL) {
+        fprintf(stderr, "Error: Memory groups are only supported with -m first-fit or paged\n");
+        exit(EXIT_FAILURE);
+    }
+    if (admission_policy != ADMIT_ANY && memory_strategy != FIRST_FIT) {
+        fprintf(stderr, "Error: --admission is only supported with -m first-fit\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((num_banks > 1 || given[OPT_PLACEMENT] || given[OPT_REMOTE_PENALTY]) && memory_strategy == INFINITE) {
+        fprintf(stderr, "Error: --banks, --placement and --remote-penalty need a finite memory strategy\n");
+        exit(EXIT_FAILURE);
+    }
+    // Page faults are served a page at a time, and swapped pages are tracked one by one, so both
+    // need a page-level replacement policy
+    if ((simulate_accesses || given[OPT_SWAP]) && replacement_policy == REPLACE_PROCESS) {
+        replacement_policy = REPLACE_LRU;
+    }
+
+    if (!restore_path) {
+        // Initialise the process manager
+        init_process_manager(&pm, num_processes, quantum);
+        pm.processes = processes;
+        if (trace.prioritised) {
+            prioritise_queue(&pm.current_processes, pm.processes, num_processes);
+        }
+        if (given[OPT_PERCENTILES]) {
+            enable_percentiles(&pm.stats);
+        }
+        init_frames(&fm);
+        fm.policy = replacement_policy;
+        fm.working_set_window = working_set_window;
+        fm.superframe_frames = superframe_frames;
+        if (simulate_accesses) {
+            init_access_model(&access_model, access_pattern, &pm, seed);
+            access_model.refs_per_quantum = refs_per_quantum;
+            access_model.fault_latency = fault_latency;
+            if (access_file) {
+                load_access_traces(&access_model, &pm, access_file);
+            }
+            fm.access_model = &access_model;
+        }
+        if (given[OPT_SWAP]) {
+            init_swap(&swap, swap_kb, swap_bandwidth, swap_full_policy, &pm);
+            fm.swap = &swap;
+        }
+        mm = init_memory_manager(mm, memory_strategy);
+        mm->compaction = compaction;
+        mm->compaction_cost = compaction_cost;
+        if (num_banks > 1) {
+            init_numa(&numa, num_banks, placement, remote_penalty);
+            assign_home_banks(&numa, &pm);
+            if (memory_strategy == FIRST_FIT) {
+                // A contiguous block cannot span banks, so a larger process would never run
+                for (int i = 0; i < pm.num_processes; i++) {
+                    if (pm.processes[i].memory_requirement > numa.bank_kb) {
+                        fprintf(stderr, "Error: Process %s needs more than one %dKB memory bank\n",
+                            pm.processes[i].name, numa.bank_kb);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                split_memory_banks(&numa, mm);
+            }
+            mm->numa = &numa;
+            fm.numa = &numa;
+        }
+        if (trace.groups.num_groups > 0 && memory_strategy != INFINITE) {
+            // A process larger than its group's quota would never run
+            for (int i = 0; i < pm.num_processes; i++) {
+                Process* process = &pm.processes[i];
+                if (process->group != NO_GROUP &&
+                        group_charge(memory_strategy, process) > trace.groups.groups[process->group].limit) {
+                    fprintf(stderr, "Error: Process %s needs more than the %dKB quota of group %s\n", process->name,
+                        trace.groups.groups[process->group].limit, trace.groups.groups[process->group].name);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            mm->groups = &trace.groups;
+            fm.groups = &trace.groups;
+        }
+    }
+
+    if (admission_policy != ADMIT_ANY) {
+        init_admission(&admission, admission_policy, &pm);
+        mm->admission = &admission;
+    }
+
+    if (checkpoint_path) {
+        schedule_checkpoint(&pm, checkpoint_path, checkpoint_at, checkpoint_every);
+    } else if (given[OPT_CHECKPOINT_AT] || given[OPT_CHECKPOINT_EVERY]) {
+        fprintf(stderr, "Error: --checkpoint-at and --checkpoint-every need a --checkpoint file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Engine engine = given['c'] ? ENGINE_PER_CORE : ENGINE_SINGLE_CORE;
+    if (given[OPT_VERIFY]) {
+        // Only the processes running the engines return
+        engine = verify_engines(&pm);
+    }
+    if (monitor_path || monitor_socket) {
+        start_monitor(&monitor, monitor_path, monitor_socket, monitor_interval, &pm, memory_strategy);
+        pm.monitor = &monitor;
+    }
+    if (engine == ENGINE_PER_CORE) {
+        init_cores(&cores, &pm, num_cores, num_threads, migration_cost, seed);
+        pm.cores = &cores;
+        multicore_scheduler(&pm, mm, &fm, &cores);
+    } else if (engine == ENGINE_REFERENCE) {
+        reference_scheduler(&pm, mm, &fm);
+    } else {
+        round_robin_scheduler(&pm, mm, &fm);
+    }
+    if (pm.monitor) {
+        stop_monitor(pm.monitor, &pm, mm, &fm);
+    }
+    if (pm.stop_time != NO_STOP) {
+        stop_replay(&pm, mm, &fm);
+    }
+    print_performance_stats(&pm);
+    print_replacement_stats(&fm);
+    print_superframe_stats(&fm);
+    print_compaction_stats(mm);
+    if (mm->admission) {
+        print_admission_stats(mm->admission);
+        free_admission(mm->admission);
+    }
+    if (mm->groups) {
+        print_group_stats(mm->groups);
+    }
+    if (fm.numa) {
+        sample_numa(fm.numa, pm.simulation_time);
+        print_numa_stats(fm.numa, memory_strategy);
+    }
+    if (pm.cores) {
+        if (num_cores > 1) {
+            print_core_stats(pm.cores, pm.simulation_time, pm.quantum);
+        }
+        free_cores(pm.cores);
+    }
+    if (fm.swap) {
+        print_swap_stats(fm.swap);
+        free_swap(fm.swap);
+    }
+    if (fm.access_model) {
+        print_access_stats(fm.access_model);
+        free_access_model(fm.access_model);
+    }
 
     // Free memory
     free_process_manager(pm);
@@ -96,7 +657,9 @@ void load_processes(ProcessManager* pm) {
 }
 
 
-void execute_process(Process* process_to_run, ProcessManager *pm, MemoryManager *mm, FrameManager *fm) {
+// Returns 1 if the process finished. Its memory is left for the caller to release, so processes
+// finishing in the same step can be released together.
+int execute_process(Process* process_to_run, ProcessManager *pm, MemoryManager *mm, FrameManager *fm) {
 
     // Run the process for the quantum time
     process_to_run->remaining_time -= pm->quantum;
@@ -111,39 +674,63 @@ void execute_process(Process* process_to_run, ProcessManager *pm, MemoryManager
         process_to_run->completion_time = pm->simulation_time;
         process_to_run->remaining_time = 0;
         pm->completed_processes++;
+        record_completion(pm, process_to_run);
+        if (mm->admission) {
+            record_progress(mm->admission, process_to_run);
+        }
 
         // If the process was finished, print the evicted frames
         if ((mm->strategy == PAGED) | (mm->strategy == VIRTUAL)) {
             printf("%d,%s,evicted-frames=", pm->simulation_time, get_status_string(EVICTED));
-            print_mem_frames(process_to_run->frames, process_to_run->num_frames);
-            release_frames(fm, process_to_run);
-            
-            if (process_to_run->frames) {
-                free(process_to_run->frames);
-                process_to_run->frames = NULL;
-            }
+            print_process_frames(fm, process_to_run);
         }
 
         load_processes(pm);
         printf("%d,%s,process-name=%s,proc-remaining=%d\n", pm->simulation_time, get_status_string(process_to_run->status),
-                    process_to_run->name, pm->current_processes.size);
-        
-        if (mm->strategy == FIRST_FIT) {
-            mm->mem_available += process_to_run->memory_requirement;
-            free_memory(mm, process_to_run); // Free the allocated memory
-        }
+                    process_to_run->name, count_ready(pm));
         pm->interrupted_process_index = NOT_INTERRUPTED;
-        
+        return 1;
     } 
+    if (mm->admission) {
+        record_progress(mm->admission, process_to_run);
+    }
+    return 0;
 }
 
 
 void round_robin_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
 
-    pm->interrupted_process_index = NOT_INTERRUPTED;    
+    // Whole rounds can be run at once unless something has to be simulated every quantum
+    int rounds_allowed = !fm->access_model && !(mm->strategy != INFINITE && fm->numa) &&
+        !(mm->strategy == PAGED && fm->superframe_frames != BASE_FRAMES_ONLY);
+    long step = 0;
+    long next_round_check = 0; // after a failed attempt, wait a round before scanning the queue again
+
+    // With priorities, the processes that could not get memory this step, kept out of the way
+    // of the ones behind them
+    int* passed_over = NULL;
+    int num_passed_over = 0;
+    if (pm->current_processes.by_priority) {
+        passed_over = (int*) malloc(pm->num_processes * sizeof(int));
+        if (!passed_over && pm->num_processes > 0) {
+            perror("Error: Failed to allocate memory for the scheduler");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // Add all arrived processes to the scheduler queue
     // Run the scheduler until all processes are completed
     while (pm->completed_processes < pm->num_processes) {
+
+        if (pm->checkpoint_path) {
+            maybe_checkpoint(pm, mm, fm);
+        }
+        if (pm->stop_time != NO_STOP && pm->simulation_time > pm->stop_time) {
+            stop_replay(pm, mm, fm);
+        }
+        if (pm->monitor) {
+            publish_progress(pm->monitor, pm, mm, fm, pm->current_processes.size + num_passed_over);
+        }
         
         load_processes(pm);
 
@@ -156,6 +743,15 @@ void round_robin_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager*
             pm->interrupted_process_index = NOT_INTERRUPTED; 
         }
 
+        if (rounds_allowed && num_passed_over == 0 && step++ >= next_round_check &&
+                !is_scheduler_empty(&pm->current_processes)) {
+            int last_run = advance_rounds(pm, mm, fm, was_interrupted);
+            if (last_run == was_interrupted) {
+                next_round_check = step + pm->current_processes.size;
+            }
+            was_interrupted = last_run;
+        }
+
         // Run the next process in the scheduler queue
         if (!is_scheduler_empty(&pm->current_processes)) {
             int process_index = dequeue(&pm->current_processes);
@@ -168,27 +764,443 @@ void round_robin_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager*
             } 
             
             if (process_to_run->memory_allocated) {
-                
+                requeue_passed_over(pm, passed_over, &num_passed_over);
+
+                if (mm->strategy == PAGED && fm->superframe_frames != BASE_FRAMES_ONLY) {
+                    promote_frames(fm, process_to_run);
+                }
                 if (was_interrupted != process_index) { // was previous process (was_interrupted) the same as current process?
                     process_to_run->status = RUNNING;
                     print_process_status(mm->strategy, pm, process_to_run, mm, fm);     
                 }
                 pm->interrupted_process_index = process_index;
                 pm->last_used_times[process_index] = pm->simulation_time;
-                execute_process(process_to_run, pm, mm, fm);
+                // Page references and memory banks are only simulated with the strategies that allow them
+                if (mm->strategy == VIRTUAL && fm->access_model) {
+                    // Faults stall the process, so their latency is added to the simulated time
+                    int faults = simulate_page_accesses(fm, pm, process_to_run);
+                    pm->simulation_time += faults * fm->access_model->fault_latency;
+                    if (fm->swap) {
+                        // So are the pages the faults moved to and from swap
+                        pm->simulation_time += charge_swap(fm->swap);
+                    }
+                } else if (mm->strategy == VIRTUAL && fm->policy != REPLACE_PROCESS) {
+                    touch_frames(fm, process_to_run, pm->simulation_time);
+                }
+                if (mm->strategy != INFINITE && fm->numa) {
+                    // Remote memory stalls the process like page faults do
+                    pm->simulation_time += charge_remote_access(fm->numa, process_to_run, pm->quantum);
+                    sample_numa(fm->numa, pm->simulation_time);
+                }
+                if (execute_process(process_to_run, pm, mm, fm)) {
+                    release_memory(&process_to_run, 1, mm, fm);
+                }
 
-            } else {
-                // Memory allocation failed, re-enqueue the process to the tail.
-                enqueue(&pm->current_processes, process_index);
+            } else if (process_to_run->status != FINISHED) {
+                // Memory allocation failed, re-enqueue the process to the tail. With priorities
+                // it is set aside until a process runs, then goes back to its place. A process
+                // killed for want of swap space has finished instead.
+                if (passed_over) {
+                    passed_over[num_passed_over++] = process_index;
+                } else {
+                    enqueue(&pm->current_processes, process_index);
+                }
             }
 
-        // If there are no processes to run, increment the simulation time
-        } else {
+        // Nothing could get memory this step, so it passes idle
+        } else if (num_passed_over > 0) {
+            requeue_passed_over(pm, passed_over, &num_passed_over);
             pm->simulation_time += pm->quantum;
+
+        // If there are no processes to run, skip to the next step where something happens
+        } else {
+            pm->simulation_time += skip_idle_time(pm);
         }
     }
+    free(passed_over);
 } 
 
+// Put the processes that could not get memory back in the queue, in the order they were passed over
+void requeue_passed_over(ProcessManager* pm, int* passed_over, int* num_passed_over) {
+
+    for (int i = 0; i < *num_passed_over; i++) {
+        enqueue(&pm->current_processes, passed_over[i]);
+    }
+    *num_passed_over = 0;
+}
+
+// Time before which the scheduler has nothing to do but run the queue: the next arrival, the
+// next snapshot, or the step where a --verify replay stops, whichever comes first
+int fast_forward_horizon(ProcessManager* pm) {
+    int horizon = __INT_MAX__;
+
+    if (pm->next_process_index < pm->num_processes) {
+        horizon = pm->processes[pm->next_process_index].time_arrived;
+    }
+    if (pm->checkpoint_path && pm->next_checkpoint_time < horizon) {
+        horizon = pm->next_checkpoint_time;
+    }
+    if (pm->stop_time != NO_STOP && pm->stop_time < horizon - 1) {
+        horizon = pm->stop_time + 1;
+    }
+    return horizon;
+}
+
+// With nothing to run, the quanta up to the first step at or after the horizon all pass idle
+int skip_idle_time(ProcessManager* pm) {
+    long gap = (long) fast_forward_horizon(pm) - pm->simulation_time;
+    long quanta = (gap + pm->quantum - 1) / pm->quantum;
+
+    if (quanta < 1 || fast_forward_horizon(pm) == __INT_MAX__) {
+        quanta = 1;
+    }
+    return quanta * pm->quantum;
+}
+
+// Run whole rounds of the queue at once while nothing else can happen: every process taking turns
+// has memory, none of them finishes, and no arrival, snapshot or replay stop falls within the
+// rounds. The events are printed just as the quantum-by-quantum loop would print them, and the
+// queue is left in the same order. Returns the process that ran last, or was_interrupted if no
+// round ran.
+int advance_rounds(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, int was_interrupted) {
+    CircularQueue* cq = &pm->current_processes;
+    int width = cq->size; // processes at the head of the queue taking turns
+
+    // With priorities, only those sharing the top priority take turns. Everything behind them is
+    // of lower priority, so each goes back to where the round needs it.
+    if (cq->by_priority) {
+        int top = pm->processes[queue_at(cq, 0)].priority;
+        width = 1;
+        while (width < cq->size && pm->processes[queue_at(cq, width)].priority == top) {
+            width++;
+        }
+    }
+    long round_time = (long) width * pm->quantum;
+    long gap = (long) fast_forward_horizon(pm) - pm->simulation_time;
+
+    // Every step of the rounds, including the one after them, must come before the horizon
+    if (gap <= round_time) {
+        return was_interrupted;
+    }
+    int min_remaining = __INT_MAX__;
+    for (int i = 0; i < width; i++) {
+        Process* process = &pm->processes[queue_at(cq, i)];
+        if (!process->memory_allocated) {
+            return was_interrupted;
+        }
+        if (process->remaining_time < min_remaining) {
+            min_remaining = process->remaining_time;
+        }
+    }
+    long rounds = (min_remaining - 1) / pm->quantum;
+    if ((gap - 1) / round_time < rounds) {
+        rounds = (gap - 1) / round_time;
+    }
+
+    // A process taking turns alone prints nothing after its first quantum, so its rounds are one step
+    if (width == 1 && rounds > 0) {
+        int process_index = queue_at(cq, 0);
+        Process* process = &pm->processes[process_index];
+        if (process_index != was_interrupted) {
+            process->status = RUNNING;
+            print_process_status(mm->strategy, pm, process, mm, fm);
+            process->status = READY;
+        }
+        process->remaining_time -= rounds * pm->quantum;
+        pm->simulation_time += rounds * pm->quantum;
+        pm->last_used_times[process_index] = pm->simulation_time - pm->quantum;
+        was_interrupted = process_index;
+        if (mm->admission) {
+            record_progress(mm->admission, process);
+        }
+    }
+    for (long r = 0; r < rounds && width > 1; r++) {
+        for (int i = 0; i < width; i++) {
+            int process_index = queue_at(cq, i);
+            Process* process = &pm->processes[process_index];
+            if (process_index != was_interrupted) {
+                process->status = RUNNING;
+                print_process_status(mm->strategy, pm, process, mm, fm);
+                process->status = READY;
+            }
+            was_interrupted = process_index;
+            pm->last_used_times[process_index] = pm->simulation_time;
+            process->remaining_time -= pm->quantum;
+            pm->simulation_time += pm->quantum;
+            if (mm->admission) {
+                record_progress(mm->admission, process);
+            }
+        }
+    }
+
+    // Only the references of the last round are left visible in the frames
+    if (rounds > 0 && mm->strategy == VIRTUAL && fm->policy != REPLACE_PROCESS) {
+        for (int i = 0; i < width; i++) {
+            int process_index = queue_at(cq, i);
+            touch_frames(fm, &pm->processes[process_index], pm->last_used_times[process_index]);
+        }
+    }
+    return was_interrupted;
+}
+
+
+// The reference engine for --verify: the round-robin loop as first written, one quantum per step,
+// with only the memory models added since. It shares none of the scheduler's fast paths (idle
+// skipping, whole rounds, batched allocation), so --verify can check them against it. Keep it
+// this way: change it only when what is simulated changes, never to make it faster.
+void reference_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
+
+    while (pm->completed_processes < pm->num_processes) {
+
+        if (pm->stop_time != NO_STOP && pm->simulation_time > pm->stop_time) {
+            stop_replay(pm, mm, fm);
+        }
+        load_processes(pm);
+
+        // Requeue the process that was interrupted by the quantum
+        int was_interrupted = pm->interrupted_process_index;
+        if (was_interrupted != NOT_INTERRUPTED) {
+            pm->processes[was_interrupted].status = READY;
+            enqueue(&pm->current_processes, was_interrupted);
+            pm->interrupted_process_index = NOT_INTERRUPTED;
+        }
+
+        // If there are no processes to run, increment the simulation time
+        if (is_scheduler_empty(&pm->current_processes)) {
+            pm->simulation_time += pm->quantum;
+            continue;
+        }
+
+        int process_index = dequeue(&pm->current_processes);
+        Process* process = &pm->processes[process_index];
+        if (!process->memory_allocated && allocate_memory(process, pm, mm, fm)) {
+            process->memory_allocated = ALLOCATED;
+        }
+        if (!process->memory_allocated) {
+            // A process killed for want of swap space has finished instead
+            if (process->status != FINISHED) {
+                enqueue(&pm->current_processes, process_index);
+            }
+            continue;
+        }
+
+        if (mm->strategy == PAGED && fm->superframe_frames != BASE_FRAMES_ONLY) {
+            promote_frames(fm, process);
+        }
+        if (was_interrupted != process_index) {
+            process->status = RUNNING;
+            print_process_status(mm->strategy, pm, process, mm, fm);
+        }
+        pm->interrupted_process_index = process_index;
+        pm->last_used_times[process_index] = pm->simulation_time;
+        if (mm->strategy == VIRTUAL && fm->access_model) {
+            pm->simulation_time += simulate_page_accesses(fm, pm, process) * fm->access_model->fault_latency;
+            if (fm->swap) {
+                pm->simulation_time += charge_swap(fm->swap);
+            }
+        } else if (mm->strategy == VIRTUAL && fm->policy != REPLACE_PROCESS) {
+            touch_frames(fm, process, pm->simulation_time);
+        }
+        if (mm->strategy != INFINITE && fm->numa) {
+            pm->simulation_time += charge_remote_access(fm->numa, process, pm->quantum);
+            sample_numa(fm->numa, pm->simulation_time);
+        }
+
+        // Run the process for the quantum, and release its memory if it finishes
+        process->remaining_time -= pm->quantum;
+        pm->simulation_time += pm->quantum;
+        if (process->remaining_time <= 0) {
+            process->status = FINISHED;
+            process->completion_time = pm->simulation_time;
+            process->remaining_time = 0;
+            pm->completed_processes++;
+            record_completion(pm, process);
+            if (mm->strategy == PAGED || mm->strategy == VIRTUAL) {
+                printf("%d,%s,evicted-frames=", pm->simulation_time, get_status_string(EVICTED));
+                print_process_frames(fm, process);
+            }
+            load_processes(pm);
+            printf("%d,%s,process-name=%s,proc-remaining=%d\n", pm->simulation_time,
+                get_status_string(process->status), process->name, count_ready(pm));
+            pm->interrupted_process_index = NOT_INTERRUPTED;
+            release_memory(&process, 1, mm, fm);
+        } else if (mm->admission) {
+            record_progress(mm->admission, process);
+        }
+    }
+}
+
+
+// Lockstep simulation of several cores, one quantum per step. Each step every core requeues the
+// process it ran, then takes the next one from its own queue (or steals one), and the chosen
+// processes run for the quantum together. Per-core work is spread across the host threads;
+// memory allocation, stealing, page references and output happen here, in core order.
+void multicore_scheduler(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs) {
+
+    while (pm->completed_processes < pm->num_processes) {
+
+        if (pm->stop_time != NO_STOP && pm->simulation_time > pm->stop_time) {
+            stop_replay(pm, mm, fm);
+        }
+        if (pm->monitor) {
+            publish_progress(pm->monitor, pm, mm, fm, count_ready(pm));
+        }
+        load_processes(pm);
+        distribute_arrivals(cs, pm);
+
+        // Requeue the processes interrupted by the quantum on the cores they ran on
+        run_phase(cs, PHASE_REQUEUE);
+
+        // Cores whose next process already has memory take it; the rest are dispatched one by one
+        int busy_cores = run_phase(cs, PHASE_CLAIM);
+        busy_cores += dispatch_cores(pm, mm, fm, cs);
+        for (int t = 0; t < cs->num_threads; t++) {
+            Worker* w = &cs->workers[t];
+            for (int i = 0; i < w->num_fresh; i++) {
+                if (cs->cores[w->fresh[i]].fresh) {
+                    start_core(pm, mm, fm, cs, w->fresh[i]);
+                }
+            }
+        }
+
+        // If no core has a process to run, increment the simulation time. With nothing queued
+        // either, skip to the next step where something happens.
+        if (busy_cores == 0) {
+            pm->simulation_time += count_ready(pm) == 0 ? skip_idle_time(pm) : pm->quantum;
+            continue;
+        }
+
+        // Every core runs the same quantum, starting after any stalls charged while dispatching
+        int step_start = pm->simulation_time;
+        run_phase(cs, PHASE_RUN);
+        if (mm->admission) {
+            // The cores run in parallel, so the admission order is brought up to date here
+            for (int c = 0; c < cs->num_cores; c++) {
+                if (cs->cores[c].current != NOT_INTERRUPTED) {
+                    record_progress(mm->admission, &pm->processes[cs->cores[c].current]);
+                }
+            }
+        }
+        int num_finished = 0;
+        for (int t = 0; t < cs->num_threads; t++) {
+            Worker* w = &cs->workers[t];
+            for (int i = 0; i < w->num_finished; i++) {
+                Core* core = &cs->cores[w->finished[i]];
+                pm->simulation_time = step_start;
+                execute_process(&pm->processes[core->current], pm, mm, fm);
+                cs->batch[num_finished++] = &pm->processes[core->current];
+                core->current = NOT_INTERRUPTED;
+            }
+        }
+        // Nothing allocates until the next step, so the finished processes are released together
+        release_memory(cs->batch, num_finished, mm, fm);
+        pm->simulation_time = step_start + pm->quantum;
+    }
+}
+
+
+// Dispatch the cores left by the claim phase, in core order. A run of cores whose next process
+// is in their own queue is allocated as one batch up to the first process that does not fit in
+// free memory; that core and the rest of the run are dispatched one by one, as is a core that
+// has to steal. Returns the number of cores made busy.
+int dispatch_cores(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs) {
+    int busy_cores = 0;
+    int num_batch = 0;
+
+    for (int t = 0; t < cs->num_threads; t++) {
+        Worker* w = &cs->workers[t];
+        for (int i = 0; i < w->num_dispatch; i++) {
+            int c = w->dispatch[i];
+            if (cs->cores[c].ready.size > 0) {
+                cs->batch_cores[num_batch] = c;
+                cs->batch[num_batch++] = &pm->processes[peek_ready(cs, c)];
+                continue;
+            }
+            busy_cores += dispatch_batch(pm, mm, fm, cs, num_batch);
+            num_batch = 0;
+            // An idle core can only steal, which needs something queued
+            if (cs->queued > 0) {
+                busy_cores += dispatch_core(pm, mm, fm, cs, c);
+            }
+        }
+    }
+    return busy_cores + dispatch_batch(pm, mm, fm, cs, num_batch);
+}
+
+// Dispatch the first num_batch cores in cs->batch_cores, whose next processes are in cs->batch
+int dispatch_batch(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs, int num_batch) {
+    int busy_cores = allocate_memory_batch(cs->batch, num_batch, pm, mm, fm);
+
+    for (int i = 0; i < busy_cores; i++) {
+        claim_process(cs, pm, cs->batch_cores[i], take_ready(cs, cs->batch_cores[i]));
+    }
+    for (int i = busy_cores; i < num_batch; i++) {
+        busy_cores += dispatch_core(pm, mm, fm, cs, cs->batch_cores[i]);
+    }
+    return busy_cores;
+}
+
+
+// Give core c the first process in its own queue that has or can get memory, otherwise one
+// stolen from another core. Returns 1 if the core is busy this step.
+int dispatch_core(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs, int c) {
+    Core* core = &cs->cores[c];
+    int own_processes = core->ready.size;
+
+    for (int attempt = 0; attempt <= own_processes; attempt++) {
+        int process_index = attempt < own_processes ? take_ready(cs, c) : steal_ready(cs, c);
+        if (process_index == NOT_INTERRUPTED) {
+            break;
+        }
+        Process* process_to_run = &pm->processes[process_index];
+
+        if (!process_to_run->memory_allocated && allocate_memory(process_to_run, pm, mm, fm)) {
+            process_to_run->memory_allocated = ALLOCATED;
+        }
+        if (!process_to_run->memory_allocated) {
+            if (process_to_run->status == FINISHED) {
+                // Killed for want of swap space
+                core->previous = NOT_INTERRUPTED;
+                continue;
+            }
+            // Memory allocation failed, re-enqueue the process to the tail of this core's queue
+            push_ready(cs, c, process_index);
+            core->previous = NOT_INTERRUPTED;
+            continue;
+        }
+        if (attempt == own_processes) {
+            core->steals++;
+        }
+        claim_process(cs, pm, c, process_index);
+        return 1;
+    }
+    return 0;
+}
+
+
+// Report a process newly put on core c and generate its page references for the quantum
+void start_core(ProcessManager* pm, MemoryManager* mm, FrameManager* fm, CoreSet* cs, int c) {
+    Core* core = &cs->cores[c];
+    Process* process_to_run = &pm->processes[core->current];
+
+    if (mm->strategy == PAGED && fm->superframe_frames != BASE_FRAMES_ONLY) {
+        promote_frames(fm, process_to_run);
+    }
+    if (core->previous != core->current) {
+        print_process_status(mm->strategy, pm, process_to_run, mm, fm);
+    }
+    if (fm->access_model) {
+        int faults = simulate_page_accesses(fm, pm, process_to_run);
+        charge_stall(cs, pm, c, faults * fm->access_model->fault_latency + (fm->swap ? charge_swap(fm->swap) : 0));
+    } else if (fm->policy != REPLACE_PROCESS) {
+        touch_frames(fm, process_to_run, pm->simulation_time);
+    }
+    if (fm->numa) {
+        charge_stall(cs, pm, c, charge_remote_access(fm->numa, process_to_run, pm->quantum));
+        sample_numa(fm->numa, pm->simulation_time);
+    }
+}
+
 
 int allocate_memory(Process* process_to_run, ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
     int allocated = NOT_ALLOCATED;
@@ -199,23 +1211,135 @@ int allocate_memory(Process* process_to_run, ProcessManager* pm, MemoryManager*
             break;
 
         case FIRST_FIT:
+            // A process whose group is at its quota waits without taking a reservation
+            if (mm->groups && !fit_group_quota(mm->groups, fm, pm, mm->strategy, process_to_run)) {
+                return NOT_ALLOCATED;
+            }
+            // Memory may be held back for an older process that is still waiting for it
+            if (mm->admission && !admit_process(mm->admission, mm, process_to_run)) {
+                break;
+            }
+            if (mm->numa) {
+                allocated = allocate_first_fit_numa(mm, pm, process_to_run);
+                break;
+            }
             allocated = allocate_first_fit(mm, process_to_run);
+
+            // Enough memory is free but no single hole fits: compact, charging for the KB moved
+            if (!allocated && mm->compaction != COMPACT_NONE &&
+                    mm->mem_available >= process_to_run->memory_requirement) {
+                int kb_moved = compact_memory(mm, process_to_run->memory_requirement, 0, MAX_KB_AVAILABLE);
+                pm->simulation_time += charge_compaction(mm, kb_moved);
+                allocated = allocate_first_fit(mm, process_to_run);
+            }
             break;
 
         case PAGED:
+            if (fm->groups && !fit_group_quota(fm->groups, fm, pm, mm->strategy, process_to_run)) {
+                break;
+            }
             allocated = allocate_pages(fm, pm, process_to_run);   
             break;
 
         case VIRTUAL:
-            allocated = allocate_virtual(fm, pm, process_to_run);
+            if (fm->policy == REPLACE_PROCESS) {
+                allocated = allocate_virtual(fm, pm, process_to_run);
+            } else {
+                allocated = allocate_virtual_pages(fm, pm, process_to_run);
+            }
+            // Evicting and loading pages waits on the swap device
+            if (fm->swap) {
+                pm->simulation_time += charge_swap(fm->swap);
+            }
             break;
         default:
             fprintf(stderr, "Unsupported memory strategy\n");
             exit(EXIT_FAILURE);
     }
 
+    if (mm->strategy == FIRST_FIT && mm->admission) {
+        record_admission(mm->admission, process_to_run, allocated);
+    }
+    if (allocated && mm->groups) {
+        charge_group(mm->groups, mm->strategy, process_to_run);
+    }
+    // Frames may have landed in other banks; charge for the remote ones
+    if (allocated && fm->numa && mm->strategy != FIRST_FIT) {
+        apply_frame_penalty(fm->numa, process_to_run);
+    }
+
+    return allocated;
+
+}
+
+// Allocate memory to the processes in order, stopping at the first one that cannot get it
+// straight from free memory (one that needs eviction or compaction). Returns how many got it;
+// the others must go through allocate_memory one at a time. Only the per-core scheduler has
+// several processes to place in a step; the single-core one dispatches one per step.
+int allocate_memory_batch(Process** processes, int n, ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
+    int allocated;
+
+    switch (mm->strategy) {
+        case INFINITE:
+            allocated = n;
+            break;
+
+        case PAGED:
+            // Superframes are placed slot by slot, and group quotas are checked process by
+            // process, so either goes one process at a time
+            if (fm->superframe_frames != BASE_FRAMES_ONLY || fm->groups) {
+                return 0;
+            }
+            allocated = allocate_pages_batch(fm, processes, n);
+            break;
+
+        default:
+            // First fit searches from the start of memory for each process, and virtual memory
+            // tops up partial allocations, so neither has a one-pass form
+            return 0;
+    }
+
+    for (int i = 0; i < allocated; i++) {
+        processes[i]->memory_allocated = ALLOCATED;
+        if (fm->numa) {
+            apply_frame_penalty(fm->numa, processes[i]);
+        }
+    }
     return allocated;
+}
+
+// Give back the memory of finished processes
+void release_memory(Process** processes, int n, MemoryManager* mm, FrameManager* fm) {
 
+    if (mm->strategy == FIRST_FIT) {
+        for (int i = 0; i < n; i++) {
+            mm->mem_available += processes[i]->memory_requirement;
+            if (mm->admission) {
+                release_admitted(mm->admission, processes[i]);
+            }
+            if (mm->groups) {
+                uncharge_group(mm->groups, mm->strategy, processes[i]);
+            }
+        }
+        free_memory_batch(mm, processes, n);
+        return;
+    }
+    if ((mm->strategy == PAGED) | (mm->strategy == VIRTUAL)) {
+        for (int i = 0; i < n; i++) {
+            if (fm->policy == REPLACE_PROCESS) {
+                release_frames(fm, processes[i]);
+            } else {
+                release_pages(fm, processes[i]);
+            }
+            if (fm->groups) {
+                uncharge_group(fm->groups, mm->strategy, processes[i]);
+            }
+            if (processes[i]->frames) {
+                free(processes[i]->frames);
+                processes[i]->frames = NULL;
+            }
+        }
+    }
 }
 
 
@@ -227,16 +1351,22 @@ int allocate_infinite(Process *process) {
 
 
 int allocate_first_fit(MemoryManager *mm, Process *process) {
+    return allocate_first_fit_range(mm, process, 0, MAX_KB_AVAILABLE);
+}
+
+// First fit among the holes starting in [lo, hi)
+int allocate_first_fit_range(MemoryManager *mm, Process *process, int lo, int hi) {
     assert(mm != NULL && mm->head != NULL);
     MemoryAddress *curr = mm->head;
 
-    while (curr) {
-        if (curr->use == HOLE && curr->length >= process->memory_requirement) {
+    while (curr && curr->starting_address < hi) {
+        if (curr->use == HOLE && curr->starting_address >= lo && curr->length >= process->memory_requirement) {
             int mem_leftover = curr->length - process->memory_requirement;
             
             // Allocate memory by resizing the current block
             curr->length = process->memory_requirement;
             curr->use = PROCESS;
+            count_bank_kb(mm, curr->starting_address, curr->length);
             process->memory_block = curr;
             process->memory_allocated = ALLOCATED;
 
@@ -266,17 +1396,57 @@ int allocate_first_fit(MemoryManager *mm, Process *process) {
     return NOT_ALLOCATED;
 }
 
-void free_memory(MemoryManager *mm, Process *process) {
-    MemoryAddress *block = process->memory_block;
-    // No memory was allocated, nothing to free
-    if (block == NULL) return; 
-    // Mark the block as free
-    block->use = HOLE; 
+// With memory banks, a block must fit inside one bank. Banks are tried in the placement
+// policy's order, compacting a bank first if it has enough free memory but no hole that fits.
+int allocate_first_fit_numa(MemoryManager *mm, ProcessManager *pm, Process *process) {
+    NumaModel *numa = mm->numa;
+    int order[MAX_BANKS];
+
+    bank_order(numa, process->home_bank, order);
+    for (int i = 0; i < numa->num_banks; i++) {
+        int lo = order[i] * numa->bank_kb;
+        int hi = lo + numa->bank_kb;
+        int allocated = allocate_first_fit_range(mm, process, lo, hi);
+
+        if (!allocated && mm->compaction != COMPACT_NONE &&
+                bank_free_kb(mm, order[i]) >= process->memory_requirement) {
+            int kb_moved = compact_memory(mm, process->memory_requirement, lo, hi);
+            pm->simulation_time += charge_compaction(mm, kb_moved);
+            allocated = allocate_first_fit_range(mm, process, lo, hi);
+        }
+        if (allocated) {
+            int local = order[i] == process->home_bank;
+            apply_remote_penalty(numa, process, order[i], local ? process->memory_requirement : 0,
+                local ? 0 : process->memory_requirement);
+            return ALLOCATED;
+        }
+    }
+    return NOT_ALLOCATED;
+}
+
+// Free the blocks of several processes with one merge pass; every run of adjacent holes is
+// merged, so the free list is the same as after freeing the blocks one at a time
+void free_memory_batch(MemoryManager *mm, Process **processes, int n) {
+    int freed = 0;
+    for (int i = 0; i < n; i++) {
+        MemoryAddress *block = processes[i]->memory_block;
+        // No memory was allocated, nothing to free
+        if (block == NULL) continue;
+        // Mark the block as free
+        block->use = HOLE;
+        count_bank_kb(mm, block->starting_address, -block->length);
+        processes[i]->memory_block = NULL;
+        processes[i]->memory_allocated = NOT_ALLOCATED;
+        freed++;
+    }
+    if (freed == 0) return;
 
     // Merge adjacent free blocks
     MemoryAddress *curr = mm->head, *prev = NULL;
     while (curr != NULL) {
-        if (curr->use == HOLE && prev != NULL && prev->use == HOLE) {
+        // Holes in different banks stay separate
+        if (curr->use == HOLE && prev != NULL && prev->use == HOLE &&
+                !(mm->numa && is_bank_start(mm->numa, curr->starting_address))) {
             // Merge current into prev
             prev->length += curr->length;
             prev->nxt = curr->nxt;
@@ -289,19 +1459,17 @@ void free_memory(MemoryManager *mm, Process *process) {
             curr = curr->nxt;
         }
     }
-    process->memory_block = NULL;
-    process->memory_allocated = NOT_ALLOCATED;
 }
 
 
 // Print status statements for any memory allocation type
 // If finished: print special finished line 
 
-void print_process_status(MemoryStrategy strategy, ProcessManager *pm, Process *process_to_run, MemoryManager *mm, FrameManager *fm) {
+void print_process_status(MemoryStrategy strategy, ProcessManager *pm, Process *process_to_run, MemoryManager *mm,
+    FrameManager *fm) {
 
     double mem_percent;
     double fmem_percent;
-    double vmem_percent;
 
     switch (strategy) {
         case INFINITE:
@@ -319,24 +1487,16 @@ void print_process_status(MemoryStrategy strategy, ProcessManager *pm, Process *
                     (int) ceil(mem_percent), process_to_run->memory_block->starting_address); 
             break;
 
+        // Paged and virtual memory report the frames a process holds the same way
         case PAGED:
+        case VIRTUAL:
             fmem_percent = (double) (fm->frames_in_use)/TOTAL_FRAMES * 100.0;
 
             printf("%d,%s,process-name=%s,remaining-time=%d,mem-usage=%d%%,", pm->simulation_time, 
                 get_status_string(process_to_run->status), process_to_run->name, process_to_run->remaining_time, 
                     (int) ceil(fmem_percent)); 
             printf("mem-frames=");
-            print_mem_frames(process_to_run->frames, process_to_run->num_frames);
-            break;
-
-        case VIRTUAL:
-            vmem_percent = (double) (fm->frames_in_use)/TOTAL_FRAMES * 100.0;
-
-            printf("%d,%s,process-name=%s,remaining-time=%d,mem-usage=%d%%,", pm->simulation_time, 
-                get_status_string(process_to_run->status), process_to_run->name, process_to_run->remaining_time, 
-                    (int) ceil(vmem_percent)); 
-            printf("mem-frames=");
-            print_mem_frames(process_to_run->frames, process_to_run->num_frames);
+            print_process_frames(fm, process_to_run);
             break;
         default:
             fprintf(stderr, "Unsupported memory strategy\n");
@@ -344,32 +1504,3 @@ void print_process_status(MemoryStrategy strategy, ProcessManager *pm, Process *
     }
 
 }
-
-void print_performance_stats(ProcessManager pm) {
-
-    int total_turnaround_time = 0;
-    int average_turnaround_time;
-    double total_overhead_time = 0;
-    double max_overhead_time = 0;
-    double average_overhead_time;
-
-    for (int i = 0; i < pm.num_processes; i++) {
-        int turnaround_time = pm.processes[i].completion_time - pm.processes[i].time_arrived;
-        double overhead_time = (double)turnaround_time/pm.processes[i].service_time;
-        // Find the maximum overhead time
-        if (overhead_time > max_overhead_time) {
-            max_overhead_time = overhead_time;
-        }
-        total_turnaround_time += turnaround_time;
-        total_overhead_time += overhead_time;
-    }
-
-    // Calculate the average turnaround and overhead time
-    average_turnaround_time = (int)ceil((double)total_turnaround_time / pm.num_processes);
-    average_overhead_time = ceil(total_overhead_time / pm.num_processes * 100) / 100.0;
-
-    printf("Turnaround time %d\n", average_turnaround_time);
-    printf("Time overhead %.2f %.2f\n", max_overhead_time, average_overhead_time);
-    printf("Makespan %d\n", pm.simulation_time);
-
-}
\ No newline at end of file
@@ -0,0 +1,393 @@
+#include "checkpoint.h"
+
+// Binary snapshot of the whole simulator at the top of a scheduling step. Restoring one and
+// continuing produces the same events as the uninterrupted run from that point on. Pointers are
+// written as indices (a process's memory block) or rebuilt from sizes (frame and page lists).
+// Snapshots are only read back by the same build of the simulator.
+
+// A memory block and its position in the block list, sortable by address in host memory
+typedef struct {
+    MemoryAddress* block;
+    int index;
+} BlockIndex;
+
+static void write_block(FILE* fp, const void* data, size_t size);
+static void read_block(FILE* fp, void* data, size_t size);
+static int compare_block_pointer(const void* a, const void* b);
+
+void schedule_checkpoint(ProcessManager* pm, char* path, int at, int every) {
+
+    pm->checkpoint_path = path;
+    pm->checkpoint_interval = every;
+
+    if (at != NO_CHECKPOINT) {
+        pm->next_checkpoint_time = at;
+    } else if (every > 0) {
+        // The first multiple of the interval after the current (possibly restored) time
+        pm->next_checkpoint_time = (pm->simulation_time / every + 1) * every;
+    } else {
+        pm->next_checkpoint_time = NO_CHECKPOINT;
+    }
+}
+
+// Called at the top of every scheduling step
+void maybe_checkpoint(ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
+
+    if (pm->simulation_time < pm->next_checkpoint_time) {
+        return;
+    }
+
+    save_checkpoint(pm->checkpoint_path, pm, mm, fm);
+
+    if (pm->checkpoint_interval > 0) {
+        while (pm->next_checkpoint_time <= pm->simulation_time) {
+            pm->next_checkpoint_time += pm->checkpoint_interval;
+        }
+    } else {
+        pm->next_checkpoint_time = NO_CHECKPOINT;
+    }
+}
+
+void save_checkpoint(const char* path, ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
+
+    // Everything printed so far belongs before the snapshot
+    fflush(stdout);
+
+    // Write to a temporary file first so a crash mid-write never leaves a truncated snapshot
+    char tmp_path[strlen(path) + 5];
+    sprintf(tmp_path, "%s.tmp", path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Could not open checkpoint file %s\n", tmp_path);
+        exit(EXIT_FAILURE);
+    }
+
+    int version = CHECKPOINT_VERSION;
+    write_block(fp, CHECKPOINT_MAGIC, strlen(CHECKPOINT_MAGIC));
+    write_block(fp, &version, sizeof(int));
+
+    // Memory manager: settings, then the block list in address order
+    int num_blocks = 0;
+    for (MemoryAddress* curr = mm->head; curr; curr = curr->nxt) {
+        num_blocks++;
+    }
+    BlockIndex* blocks = (BlockIndex*) malloc((num_blocks + 1) * sizeof(BlockIndex));
+    assert(blocks != NULL);
+    num_blocks = 0;
+    for (MemoryAddress* curr = mm->head; curr; curr = curr->nxt) {
+        blocks[num_blocks].block = curr;
+        blocks[num_blocks].index = num_blocks;
+        num_blocks++;
+    }
+
+    write_block(fp, &mm->strategy, sizeof(MemoryStrategy));
+    write_block(fp, &mm->mem_available, sizeof(int));
+    write_block(fp, &mm->compaction, sizeof(CompactionMode));
+    write_block(fp, &mm->compaction_cost, sizeof(double));
+    write_block(fp, &mm->compaction_debt, sizeof(double));
+    write_block(fp, &mm->kb_moved, sizeof(long));
+    write_block(fp, &mm->compactions, sizeof(int));
+    write_block(fp, &num_blocks, sizeof(int));
+    for (int i = 0; i < num_blocks; i++) {
+        write_block(fp, &blocks[i].block->use, sizeof(int));
+        write_block(fp, &blocks[i].block->starting_address, sizeof(int));
+        write_block(fp, &blocks[i].block->length, sizeof(int));
+    }
+
+    // Process manager, with the scheduler queue written from head to tail
+    write_block(fp, &pm->num_processes, sizeof(int));
+    write_block(fp, &pm->simulation_time, sizeof(int));
+    write_block(fp, &pm->quantum, sizeof(int));
+    write_block(fp, &pm->completed_processes, sizeof(int));
+    write_block(fp, &pm->next_process_index, sizeof(int));
+    write_block(fp, &pm->interrupted_process_index, sizeof(int));
+    write_block(fp, pm->last_used_times, pm->num_processes * sizeof(int));
+    write_block(fp, &pm->current_processes.size, sizeof(int));
+    for (int i = 0; i < pm->current_processes.size; i++) {
+        int process_index = queue_at(&pm->current_processes, i);
+        write_block(fp, &process_index, sizeof(int));
+    }
+    int prioritised = pm->current_processes.by_priority != NULL;
+    write_block(fp, &prioritised, sizeof(int));
+
+    // Processes, each followed by its block index and frame and page lists
+    qsort(blocks, num_blocks, sizeof(BlockIndex), compare_block_pointer);
+    write_block(fp, pm->processes, pm->num_processes * sizeof(Process));
+    for (int i = 0; i < pm->num_processes; i++) {
+        Process* process = &pm->processes[i];
+        int block_index = NOT_IN_USE;
+
+        if (process->memory_block) {
+            BlockIndex key = {process->memory_block, 0};
+            BlockIndex* found = bsearch(&key, blocks, num_blocks, sizeof(BlockIndex), compare_block_pointer);
+            assert(found != NULL);
+            block_index = found->index;
+        }
+        write_block(fp, &block_index, sizeof(int));
+
+        int capacity = process->frames ? ceil((double) process->memory_requirement / FRAME_SIZE) : 0;
+        write_block(fp, &capacity, sizeof(int));
+        write_block(fp, process->frames, capacity * sizeof(int));
+
+        int num_pages = process->page_table ? process->num_pages : 0;
+        write_block(fp, &num_pages, sizeof(int));
+        write_block(fp, process->page_table, num_pages * sizeof(int));
+    }
+    free(blocks);
+
+    // Statistics of the processes finished so far, with the overheads still waiting to be summed
+    RunStats* stats = &pm->stats;
+    write_block(fp, &stats->total_turnaround, sizeof(long));
+    write_block(fp, &stats->total_overhead, sizeof(double));
+    write_block(fp, &stats->max_overhead, sizeof(double));
+    write_block(fp, &stats->next_summed, sizeof(int));
+    write_block(fp, &stats->pending_capacity, sizeof(int));
+    write_block(fp, stats->pending_overhead, stats->pending_capacity * sizeof(double));
+    int has_sketches = stats->turnaround_sketch != NULL;
+    write_block(fp, &has_sketches, sizeof(int));
+    if (has_sketches) {
+        write_block(fp, stats->turnaround_sketch, sizeof(Sketch));
+        write_block(fp, stats->overhead_sketch, sizeof(Sketch));
+    }
+
+    // Frame manager is pointer free apart from the access and bank models
+    write_block(fp, fm, sizeof(FrameManager));
+
+    // The bank model is pointer free and shared by both managers
+    int has_numa = fm->numa != NULL;
+    write_block(fp, &has_numa, sizeof(int));
+    if (has_numa) {
+        write_block(fp, fm->numa, sizeof(NumaModel));
+    }
+
+    // So are the memory groups
+    int has_groups = fm->groups != NULL;
+    write_block(fp, &has_groups, sizeof(int));
+    if (has_groups) {
+        write_block(fp, fm->groups, sizeof(GroupTable));
+    }
+
+    int has_access_model = fm->access_model != NULL;
+    write_block(fp, &has_access_model, sizeof(int));
+    if (has_access_model) {
+        AccessModel* am = fm->access_model;
+        write_block(fp, &am->pattern, sizeof(AccessPattern));
+        write_block(fp, &am->refs_per_quantum, sizeof(int));
+        write_block(fp, &am->fault_latency, sizeof(int));
+        write_block(fp, &am->references, sizeof(long));
+        write_block(fp, &am->faults, sizeof(long));
+        write_block(fp, am->rng_state, am->num_processes * sizeof(unsigned long long));
+        write_block(fp, am->cursor, am->num_processes * sizeof(int));
+
+        int has_traces = am->traces != NULL;
+        write_block(fp, &has_traces, sizeof(int));
+        for (int i = 0; has_traces && i < am->num_processes; i++) {
+            write_block(fp, &am->traces[i].length, sizeof(int));
+            write_block(fp, am->traces[i].pages, am->traces[i].length * sizeof(int));
+        }
+    }
+
+    if (fclose(fp) != 0 || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Error: Could not write checkpoint file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Rebuild the state saved by save_checkpoint. mm must come from create_memory_manager.
+void load_checkpoint(const char* path, ProcessManager* pm, MemoryManager* mm, FrameManager* fm, AccessModel* am,
+    NumaModel* numa, GroupTable* groups) {
+
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Could not open checkpoint file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    char magic[sizeof(CHECKPOINT_MAGIC)] = {0};
+    int version;
+    read_block(fp, magic, strlen(CHECKPOINT_MAGIC));
+    read_block(fp, &version, sizeof(int));
+    if (strcmp(magic, CHECKPOINT_MAGIC) != 0 || version != CHECKPOINT_VERSION) {
+        fprintf(stderr, "Error: %s is not a compatible checkpoint\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    int num_blocks;
+    read_block(fp, &mm->strategy, sizeof(MemoryStrategy));
+    read_block(fp, &mm->mem_available, sizeof(int));
+    read_block(fp, &mm->compaction, sizeof(CompactionMode));
+    read_block(fp, &mm->compaction_cost, sizeof(double));
+    read_block(fp, &mm->compaction_debt, sizeof(double));
+    read_block(fp, &mm->kb_moved, sizeof(long));
+    read_block(fp, &mm->compactions, sizeof(int));
+    read_block(fp, &num_blocks, sizeof(int));
+
+    MemoryAddress** blocks = (MemoryAddress**) malloc((num_blocks + 1) * sizeof(MemoryAddress*));
+    assert(blocks != NULL);
+    for (int i = 0; i < num_blocks; i++) {
+        blocks[i] = (MemoryAddress*) malloc(sizeof(MemoryAddress));
+        assert(blocks[i] != NULL);
+        read_block(fp, &blocks[i]->use, sizeof(int));
+        read_block(fp, &blocks[i]->starting_address, sizeof(int));
+        read_block(fp, &blocks[i]->length, sizeof(int));
+        blocks[i]->prev = i > 0 ? blocks[i - 1] : NULL;
+        blocks[i]->nxt = NULL;
+        if (i > 0) {
+            blocks[i - 1]->nxt = blocks[i];
+        }
+    }
+    mm->head = num_blocks > 0 ? blocks[0] : NULL;
+    mm->tail = num_blocks > 0 ? blocks[num_blocks - 1] : NULL;
+
+    int num_processes, quantum, queue_size, prioritised;
+    read_block(fp, &num_processes, sizeof(int));
+    read_block(fp, &pm->simulation_time, sizeof(int));
+    read_block(fp, &quantum, sizeof(int));
+
+    int simulation_time = pm->simulation_time;
+    init_process_manager(pm, num_processes, quantum);
+    pm->simulation_time = simulation_time;
+    read_block(fp, &pm->completed_processes, sizeof(int));
+    read_block(fp, &pm->next_process_index, sizeof(int));
+    read_block(fp, &pm->interrupted_process_index, sizeof(int));
+    read_block(fp, pm->last_used_times, num_processes * sizeof(int));
+    read_block(fp, &queue_size, sizeof(int));
+    for (int i = 0; i < queue_size; i++) {
+        int process_index;
+        read_block(fp, &process_index, sizeof(int));
+        enqueue(&pm->current_processes, process_index);
+    }
+    read_block(fp, &prioritised, sizeof(int));
+
+    pm->processes = (Process*) malloc(num_processes * sizeof(Process));
+    if (!pm->processes && num_processes > 0) {
+        perror("Error: Could not allocate memory for processes.");
+        exit(EXIT_FAILURE);
+    }
+    read_block(fp, pm->processes, num_processes * sizeof(Process));
+    for (int i = 0; i < num_processes; i++) {
+        Process* process = &pm->processes[i];
+        int block_index, capacity, num_pages;
+
+        read_block(fp, &block_index, sizeof(int));
+        process->memory_block = block_index != NOT_IN_USE ? blocks[block_index] : NULL;
+
+        read_block(fp, &capacity, sizeof(int));
+        process->frames = NULL;
+        if (capacity > 0) {
+            process->frames = (int*) malloc(capacity * sizeof(int));
+            assert(process->frames != NULL);
+            read_block(fp, process->frames, capacity * sizeof(int));
+        }
+
+        read_block(fp, &num_pages, sizeof(int));
+        process->page_table = NULL;
+        if (num_pages > 0) {
+            process->page_table = (int*) malloc(num_pages * sizeof(int));
+            assert(process->page_table != NULL);
+            read_block(fp, process->page_table, num_pages * sizeof(int));
+        }
+    }
+    free(blocks);
+    // The queue was read back in order; from here on it keeps the priorities
+    if (prioritised) {
+        prioritise_queue(&pm->current_processes, pm->processes, num_processes);
+    }
+
+    RunStats* stats = &pm->stats;
+    read_block(fp, &stats->total_turnaround, sizeof(long));
+    read_block(fp, &stats->total_overhead, sizeof(double));
+    read_block(fp, &stats->max_overhead, sizeof(double));
+    read_block(fp, &stats->next_summed, sizeof(int));
+    read_block(fp, &stats->pending_capacity, sizeof(int));
+    if (stats->pending_capacity > 0) {
+        stats->pending_overhead = (double*) malloc(stats->pending_capacity * sizeof(double));
+        assert(stats->pending_overhead != NULL);
+        read_block(fp, stats->pending_overhead, stats->pending_capacity * sizeof(double));
+    }
+    int has_sketches;
+    read_block(fp, &has_sketches, sizeof(int));
+    if (has_sketches) {
+        enable_percentiles(stats);
+        read_block(fp, stats->turnaround_sketch, sizeof(Sketch));
+        read_block(fp, stats->overhead_sketch, sizeof(Sketch));
+    }
+
+    read_block(fp, fm, sizeof(FrameManager));
+    fm->access_model = NULL;
+    fm->numa = NULL;
+    fm->swap = NULL;
+    fm->groups = NULL;
+
+    int has_numa;
+    read_block(fp, &has_numa, sizeof(int));
+    if (has_numa) {
+        read_block(fp, numa, sizeof(NumaModel));
+        fm->numa = numa;
+        mm->numa = numa;
+    }
+
+    int has_groups;
+    read_block(fp, &has_groups, sizeof(int));
+    if (has_groups) {
+        read_block(fp, groups, sizeof(GroupTable));
+        fm->groups = groups;
+        mm->groups = groups;
+    }
+
+    int has_access_model;
+    read_block(fp, &has_access_model, sizeof(int));
+    if (has_access_model) {
+        int has_traces;
+        AccessPattern pattern;
+
+        read_block(fp, &pattern, sizeof(AccessPattern));
+        init_access_model(am, pattern, pm, DEFAULT_ACCESS_SEED);
+        read_block(fp, &am->refs_per_quantum, sizeof(int));
+        read_block(fp, &am->fault_latency, sizeof(int));
+        read_block(fp, &am->references, sizeof(long));
+        read_block(fp, &am->faults, sizeof(long));
+        read_block(fp, am->rng_state, num_processes * sizeof(unsigned long long));
+        read_block(fp, am->cursor, num_processes * sizeof(int));
+
+        read_block(fp, &has_traces, sizeof(int));
+        if (has_traces) {
+            am->traces = (AccessTrace*) calloc(num_processes, sizeof(AccessTrace));
+            assert(am->traces != NULL);
+            for (int i = 0; i < num_processes; i++) {
+                AccessTrace* trace = &am->traces[i];
+                read_block(fp, &trace->length, sizeof(int));
+                trace->capacity = trace->length;
+                trace->pages = (int*) malloc(trace->length * sizeof(int));
+                assert(trace->pages != NULL || trace->length == 0);
+                read_block(fp, trace->pages, trace->length * sizeof(int));
+            }
+        }
+        fm->access_model = am;
+    }
+
+    fclose(fp);
+}
+
+static void write_block(FILE* fp, const void* data, size_t size) {
+
+    if (size > 0 && fwrite(data, size, 1, fp) != 1) {
+        perror("Error: Could not write checkpoint");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void read_block(FILE* fp, void* data, size_t size) {
+
+    if (size > 0 && fread(data, size, 1, fp) != 1) {
+        fprintf(stderr, "Error: Checkpoint file is truncated\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static int compare_block_pointer(const void* a, const void* b) {
+
+    MemoryAddress* p1 = ((const BlockIndex*) a)->block;
+    MemoryAddress* p2 = ((const BlockIndex*) b)->block;
+    return (p1 > p2) - (p1 < p2);
+}
@@ -0,0 +1,17 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "access_model.h"
+#include "numa.h"
+#include "stats.h"
+
+#define CHECKPOINT_MAGIC "ALLOCCKP"
+#define CHECKPOINT_VERSION 7
+#define NO_CHECKPOINT __INT_MAX__
+
+void schedule_checkpoint(ProcessManager* pm, char* path, int at, int every);
+void maybe_checkpoint(ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
+void save_checkpoint(const char* path, ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
+void load_checkpoint(const char* path, ProcessManager* pm, MemoryManager* mm, FrameManager* fm, AccessModel* am,
+    NumaModel* numa, GroupTable* groups);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,91 @@
+#include "groups.h"
+
+static Process* find_lru_in_group(ProcessManager* pm, Process* cur);
+
+
+// KB a process holds against its group: what it asked for under first fit, whole frames when paged
+int group_charge(MemoryStrategy strategy, Process* process) {
+
+    if (strategy == PAGED) {
+        return (int) ceil((double) process->memory_requirement / FRAME_SIZE) * FRAME_SIZE;
+    }
+    return process->memory_requirement;
+}
+
+// Whether the process can take its memory without its group going over quota. When paged, the
+// group's least recently run processes are evicted to make room, as a cgroup reclaims its own
+// pages first; first fit cannot take memory back, so there the process waits.
+int fit_group_quota(GroupTable* groups, FrameManager* fm, ProcessManager* pm, MemoryStrategy strategy,
+    Process* process) {
+
+    if (process->group == NO_GROUP) {
+        return ALLOCATED;
+    }
+    MemoryGroup* group = &groups->groups[process->group];
+    int charge = group_charge(strategy, process);
+
+    while (strategy == PAGED && group->used + charge > group->limit) {
+        Process* victim = find_lru_in_group(pm, process);
+        if (victim == NULL) {
+            break;
+        }
+        victim->memory_allocated = NOT_ALLOCATED;
+        print_eviction_notice(pm, fm, victim);
+        release_frames(fm, victim);
+        uncharge_group(groups, strategy, victim);
+        group->reclaimed++;
+    }
+    if (group->used + charge > group->limit) {
+        group->refused++;
+        return NOT_ALLOCATED;
+    }
+    return ALLOCATED;
+}
+
+void charge_group(GroupTable* groups, MemoryStrategy strategy, Process* process) {
+
+    if (process->group == NO_GROUP) {
+        return;
+    }
+    MemoryGroup* group = &groups->groups[process->group];
+    group->used += group_charge(strategy, process);
+    if (group->used > group->peak) {
+        group->peak = group->used;
+    }
+}
+
+void uncharge_group(GroupTable* groups, MemoryStrategy strategy, Process* process) {
+
+    if (process->group != NO_GROUP) {
+        groups->groups[process->group].used -= group_charge(strategy, process);
+    }
+}
+
+void print_group_stats(GroupTable* groups) {
+
+    for (int g = 0; g < groups->num_groups; g++) {
+        MemoryGroup* group = &groups->groups[g];
+        printf("Group %s peak %dKB of %dKB, refused %ld, reclaimed %ld\n", group->name, group->peak, group->limit,
+            group->refused, group->reclaimed);
+    }
+}
+
+
+// As find_lru_process, among the resident processes of cur's group
+static Process* find_lru_in_group(ProcessManager* pm, Process* cur) {
+    int min_time = __INT_MAX__;
+    Process* lru_process = NULL;
+
+    for (int i = 0; i < pm->num_processes; i++) {
+        Process* process = &pm->processes[i];
+        if (process->group != cur->group || process->num_frames == 0 || process == cur ||
+                process->status == RUNNING) {
+            continue;
+        }
+        if (pm->last_used_times[i] < min_time) {
+            min_time = pm->last_used_times[i];
+            lru_process = process;
+        }
+    }
+    return lru_process;
+}
@@ -0,0 +1,12 @@
+#ifndef GROUPS_H
+#define GROUPS_H
+#include "paged_allocation.h"
+
+int group_charge(MemoryStrategy strategy, Process* process);
+int fit_group_quota(GroupTable* groups, FrameManager* fm, ProcessManager* pm, MemoryStrategy strategy,
+    Process* process);
+void charge_group(GroupTable* groups, MemoryStrategy strategy, Process* process);
+void uncharge_group(GroupTable* groups, MemoryStrategy strategy, Process* process);
+void print_group_stats(GroupTable* groups);
+
+#endif // GROUPS_H
@@ -10,6 +10,14 @@ MemoryManager* create_memory_manager() {
     mm->head = NULL;
     mm->tail = NULL;
     mm->mem_available = MAX_KB_AVAILABLE;
+    mm->compaction = COMPACT_NONE;
+    mm->compaction_cost = DEFAULT_COMPACTION_COST;
+    mm->compaction_debt = 0;
+    mm->kb_moved = 0;
+    mm->compactions = 0;
+    mm->numa = NULL;
+    mm->admission = NULL;
+    mm->groups = NULL;
 
     return mm;
 }
@@ -59,4 +67,127 @@ int compare_mem_address(MemoryAddress* a1, MemoryAddress* a2) {
     }
 }
 
+int parse_compaction_mode(const char* name, CompactionMode* mode) {
 
+    if (strcmp(name, "full") == 0) {
+        *mode = COMPACT_FULL;
+    } else if (strcmp(name, "partial") == 0) {
+        *mode = COMPACT_PARTIAL;
+    } else {
+        return NOT_SAME;
+    }
+    return SAME;
+}
+
+// Relocate resident blocks so that a hole of at least `required` KB exists. Blocks in the chosen
+// window slide down over the holes in it, which merge into one hole at the end of the window.
+// Full compaction takes the window from the first hole to the end of memory. Partial compaction
+// takes the window, starting at a hole, that moves the fewest KB. Only blocks in [lo, hi) are
+// considered (one bank, when memory is split into banks). Returns the number of KB moved.
+int compact_memory(MemoryManager* mm, int required, int lo, int hi) {
+
+    MemoryAddress* before_window = NULL; // block preceding the window, NULL if it starts at head
+    MemoryAddress* first = NULL;
+    MemoryAddress* last = NULL;
+    int best_cost = __INT_MAX__;
+
+    MemoryAddress* prev = NULL;
+    for (MemoryAddress* start = mm->head; start; prev = start, start = start->nxt) {
+        if (start->use != HOLE || start->starting_address < lo) {
+            continue;
+        }
+        if (start->starting_address >= hi) {
+            break;
+        }
+
+        int free_kb = 0;
+        int cost = 0;
+        MemoryAddress* end = start;
+        for (MemoryAddress* curr = start; curr && curr->starting_address < hi; curr = curr->nxt) {
+            end = curr;
+            if (curr->use == HOLE) {
+                free_kb += curr->length;
+            } else {
+                cost += curr->length;
+            }
+            if (mm->compaction == COMPACT_PARTIAL && free_kb >= required) {
+                break;
+            }
+        }
+        if (free_kb < required) {
+            break;
+        }
+
+        if (cost < best_cost) {
+            best_cost = cost;
+            before_window = prev;
+            first = start;
+            last = end;
+        }
+        if (mm->compaction == COMPACT_FULL) {
+            break;
+        }
+    }
+
+    if (first == NULL) {
+        return 0;
+    }
+
+    // Relink the window as its resident blocks, in order, followed by the merged hole
+    MemoryAddress* after_window = last->nxt;
+    MemoryAddress* hole = first;
+    MemoryAddress* tail = before_window;
+    int address = first->starting_address;
+    int hole_length = 0;
+
+    MemoryAddress* curr = first;
+    while (curr != after_window) {
+        MemoryAddress* nxt = curr->nxt;
+        if (curr->use == HOLE) {
+            hole_length += curr->length;
+            if (curr != hole) {
+                free(curr);
+            }
+        } else {
+            curr->starting_address = address;
+            address += curr->length;
+            if (tail) {
+                tail->nxt = curr;
+            } else {
+                mm->head = curr;
+            }
+            tail = curr;
+        }
+        curr = nxt;
+    }
+
+    hole->starting_address = address;
+    hole->length = hole_length;
+    hole->nxt = after_window;
+    if (tail) {
+        tail->nxt = hole;
+    } else {
+        mm->head = hole;
+    }
+
+    mm->kb_moved += best_cost;
+    mm->compactions++;
+    return best_cost;
+}
+
+// Convert KB moved into whole units of simulated time, carrying any fraction to the next compaction
+int charge_compaction(MemoryManager* mm, int kb_moved) {
+
+    mm->compaction_debt += kb_moved * mm->compaction_cost;
+    int charge = (int) mm->compaction_debt;
+    mm->compaction_debt -= charge;
+    return charge;
+}
+
+void print_compaction_stats(MemoryManager* mm) {
+
+    if (mm->compaction != COMPACT_NONE) {
+        printf("Compactions %d\n", mm->compactions);
+        printf("Compaction moved %ldKB\n", mm->kb_moved);
+    }
+}
@@ -17,6 +17,7 @@
 #define NOT_ALLOCATED 0
 #define SAME 1 // Comparison is true
 #define NOT_SAME 0 // Comparison is false
+#define DEFAULT_COMPACTION_COST 0.01 // simulated time per KB relocated by compaction
 
 
 typedef enum {
@@ -26,6 +27,12 @@ typedef enum {
     VIRTUAL
 } MemoryStrategy;
 
+typedef enum {
+    COMPACT_NONE,
+    COMPACT_FULL, // slide every resident block down to address 0
+    COMPACT_PARTIAL // slide only the cheapest run of blocks that frees a large enough hole
+} CompactionMode;
+
 typedef struct MemoryAddress MemoryAddress;
 
 typedef struct MemoryAddress {
@@ -42,6 +49,14 @@ typedef struct MemoryManager {
     MemoryAddress* tail; // Pointer to the last memory block
     int mem_available; // Amount of memory still free to be allocated 
     MemoryStrategy strategy; // The strategy used to allocate memory
+    CompactionMode compaction; // What to do when first-fit fails only because memory is fragmented
+    double compaction_cost; // Simulated time charged per KB moved
+    double compaction_debt; // Fraction of a time unit charged but not yet added to the simulation
+    long kb_moved;
+    int compactions;
+    struct NumaModel* numa; // Memory banks, or NULL for one flat memory
+    struct AdmissionControl* admission; // Who may take first-fit memory, or NULL for anyone that fits
+    struct GroupTable* groups; // Memory groups and their quotas, shared with the frame manager, or NULL
 } MemoryManager;
 
 // Function prototypes for managing the memory
@@ -49,5 +64,9 @@ MemoryManager* create_memory_manager(void);
 MemoryManager* init_memory_manager(MemoryManager* mm, MemoryStrategy strategy);
 void free_memory_manager(MemoryManager* mm);
 int compare_mem_address(MemoryAddress* a1, MemoryAddress* a2);
+int parse_compaction_mode(const char* name, CompactionMode* mode);
+int compact_memory(MemoryManager* mm, int required, int lo, int hi);
+int charge_compaction(MemoryManager* mm, int kb_moved);
+void print_compaction_stats(MemoryManager* mm);
 
 #endif // MEMORY_MANAGER_H
\ No newline at end of file
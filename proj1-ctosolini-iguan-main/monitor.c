@@ -0,0 +1,248 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "monitor.h"
+
+static void* sampler_loop(void* arg);
+static void take_snapshot(Monitor* monitor, MonitorSnapshot* snapshot);
+static void sample_rates(Monitor* monitor, MonitorSnapshot* snapshot);
+static int format_report(Monitor* monitor, MonitorSnapshot* snapshot, char* report, int finished);
+static void write_report_file(Monitor* monitor, const char* report, int length);
+static void serve_connection(Monitor* monitor);
+static int open_monitor_socket(const char* path);
+static double seconds_between(struct timespec* from, struct timespec* to);
+
+
+void start_monitor(Monitor* monitor, char* path, char* socket_path, int interval, ProcessManager* pm,
+    MemoryStrategy strategy) {
+
+    memset(monitor, 0, sizeof(Monitor));
+    monitor->path = path;
+    monitor->socket_path = socket_path;
+    monitor->interval = interval;
+    monitor->strategy = strategy;
+    monitor->num_processes = pm->num_processes;
+    monitor->listen_fd = -1;
+    atomic_init(&monitor->simulation_time, pm->simulation_time);
+    atomic_init(&monitor->completed, pm->completed_processes);
+    monitor->last_time = pm->simulation_time;
+    clock_gettime(CLOCK_MONOTONIC, &monitor->started);
+    monitor->last_sampled = monitor->started;
+
+    if (socket_path) {
+        monitor->listen_fd = open_monitor_socket(socket_path);
+    }
+    if (pipe(monitor->wake_fd) != 0) {
+        perror("Error: Failed to create the monitor pipe");
+        exit(EXIT_FAILURE);
+    }
+    if (pthread_create(&monitor->thread, NULL, sampler_loop, monitor) != 0) {
+        fprintf(stderr, "Error: Failed to start the monitor thread\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Publish the final state, let the sampler write it out, and take the socket down
+void stop_monitor(Monitor* monitor, ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
+    char stop = 0;
+
+    publish_progress(monitor, pm, mm, fm, 0);
+    if (write(monitor->wake_fd[1], &stop, 1) != 1) {
+        perror("Error: Failed to stop the monitor thread");
+        exit(EXIT_FAILURE);
+    }
+    pthread_join(monitor->thread, NULL);
+    close(monitor->wake_fd[0]);
+    close(monitor->wake_fd[1]);
+    if (monitor->listen_fd >= 0) {
+        close(monitor->listen_fd);
+        unlink(monitor->socket_path);
+    }
+}
+
+
+// Wake every interval to take the rates and rewrite the file, and whenever a client connects
+static void* sampler_loop(void* arg) {
+    Monitor* monitor = arg;
+    char report[MAX_MONITOR_REPORT];
+    MonitorSnapshot snapshot;
+    struct timespec now, next_sample = monitor->started;
+
+    while (1) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int wait = (int) (seconds_between(&now, &next_sample) * 1000);
+        if (wait <= 0) {
+            take_snapshot(monitor, &snapshot);
+            sample_rates(monitor, &snapshot);
+            if (monitor->path) {
+                int length = format_report(monitor, &snapshot, report, 0);
+                write_report_file(monitor, report, length);
+            }
+            next_sample = now;
+            next_sample.tv_sec += monitor->interval / 1000;
+            next_sample.tv_nsec += (monitor->interval % 1000) * 1000000L;
+            if (next_sample.tv_nsec >= 1000000000L) {
+                next_sample.tv_sec++;
+                next_sample.tv_nsec -= 1000000000L;
+            }
+            wait = monitor->interval;
+        }
+
+        struct pollfd fds[2] = {{monitor->wake_fd[0], POLLIN, 0}, {monitor->listen_fd, POLLIN, 0}};
+        if (poll(fds, monitor->listen_fd >= 0 ? 2 : 1, wait) < 0 && errno != EINTR) {
+            perror("Error: Monitor poll failed");
+            exit(EXIT_FAILURE);
+        }
+        if (fds[0].revents) {
+            break;
+        }
+        if (monitor->listen_fd >= 0 && fds[1].revents) {
+            serve_connection(monitor);
+        }
+    }
+
+    if (monitor->path) {
+        take_snapshot(monitor, &snapshot);
+        sample_rates(monitor, &snapshot);
+        int length = format_report(monitor, &snapshot, report, 1);
+        write_report_file(monitor, report, length);
+    }
+    return NULL;
+}
+
+// Copy the published counters, retrying while the scheduler is part way through an update
+static void take_snapshot(Monitor* monitor, MonitorSnapshot* snapshot) {
+    unsigned seq;
+
+    do {
+        seq = atomic_load_explicit(&monitor->seq, memory_order_acquire);
+        snapshot->simulation_time = atomic_load_explicit(&monitor->simulation_time, memory_order_relaxed);
+        snapshot->completed = atomic_load_explicit(&monitor->completed, memory_order_relaxed);
+        snapshot->queued = atomic_load_explicit(&monitor->queued, memory_order_relaxed);
+        snapshot->kb_used = atomic_load_explicit(&monitor->kb_used, memory_order_relaxed);
+        snapshot->frames_used = atomic_load_explicit(&monitor->frames_used, memory_order_relaxed);
+        snapshot->steps = atomic_load_explicit(&monitor->steps, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&monitor->seq, memory_order_relaxed));
+}
+
+// Rates cover the time since the previous sample. Only the sampler's own tick calls this.
+static void sample_rates(Monitor* monitor, MonitorSnapshot* snapshot) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = seconds_between(&monitor->last_sampled, &now);
+    if (elapsed > 0) {
+        monitor->steps_per_sec = (snapshot->steps - monitor->last_steps) / elapsed;
+        monitor->time_per_sec = (snapshot->simulation_time - monitor->last_time) / elapsed;
+        monitor->last_sampled = now;
+        monitor->last_steps = snapshot->steps;
+        monitor->last_time = snapshot->simulation_time;
+    }
+}
+
+// The counters are as of the snapshot and the rates as of the last sample
+static int format_report(Monitor* monitor, MonitorSnapshot* snapshot, char* report, int finished) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int length = snprintf(report, MAX_MONITOR_REPORT,
+        "state=%s\nsimulation-time=%d\ncompleted=%d\nremaining=%d\nqueue-length=%d\n",
+        finished ? "finished" : "running", snapshot->simulation_time, snapshot->completed,
+        monitor->num_processes - snapshot->completed, snapshot->queued);
+    if (monitor->strategy == FIRST_FIT) {
+        length += snprintf(report + length, MAX_MONITOR_REPORT - length,
+            "memory-used=%dKB\nmemory-utilisation=%.2f%%\n", snapshot->kb_used,
+            snapshot->kb_used * 100.0 / MAX_KB_AVAILABLE);
+    } else if (monitor->strategy != INFINITE) {
+        length += snprintf(report + length, MAX_MONITOR_REPORT - length,
+            "frames-used=%d\nframe-utilisation=%.2f%%\n", snapshot->frames_used,
+            snapshot->frames_used * 100.0 / TOTAL_FRAMES);
+    }
+    length += snprintf(report + length, MAX_MONITOR_REPORT - length,
+        "steps-per-sec=%.0f\nsimulated-time-per-sec=%.0f\nwall-time=%.1fs\n",
+        monitor->steps_per_sec, monitor->time_per_sec, seconds_between(&monitor->started, &now));
+    return length;
+}
+
+// Written beside the file and renamed over it, so a reader never sees half a report
+static void write_report_file(Monitor* monitor, const char* report, int length) {
+    char tmp_path[strlen(monitor->path) + 5];
+
+    sprintf(tmp_path, "%s.tmp", monitor->path);
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) {
+        perror("Error: Failed to write the monitor file");
+        exit(EXIT_FAILURE);
+    }
+    fwrite(report, 1, length, fp);
+    if (fclose(fp) != 0 || rename(tmp_path, monitor->path) != 0) {
+        perror("Error: Failed to write the monitor file");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Each client gets one report and the connection is closed. A client that goes away early does
+// not matter to the run.
+static void serve_connection(Monitor* monitor) {
+    char report[MAX_MONITOR_REPORT];
+    MonitorSnapshot snapshot;
+
+    int fd = accept(monitor->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    take_snapshot(monitor, &snapshot);
+    int length = format_report(monitor, &snapshot, report, 0);
+    int sent = 0;
+    while (sent < length) {
+        ssize_t n = send(fd, report + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+    close(fd);
+}
+
+// A socket left behind by an earlier run is replaced; any other file in the way is an error
+static int open_monitor_socket(const char* path) {
+    struct sockaddr_un addr;
+    struct stat st;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Monitor socket path %s is too long\n", path);
+        exit(EXIT_FAILURE);
+    }
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Error: %s exists and is not a socket\n", path);
+            exit(EXIT_FAILURE);
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Error: Failed to create the monitor socket");
+        exit(EXIT_FAILURE);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        perror("Error: Failed to open the monitor socket");
+        exit(EXIT_FAILURE);
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+static double seconds_between(struct timespec* from, struct timespec* to) {
+
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
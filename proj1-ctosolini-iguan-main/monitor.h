@@ -0,0 +1,75 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "paged_allocation.h"
+
+#define DEFAULT_MONITOR_INTERVAL 1000 // milliseconds between samples of the rates and rewrites of the file
+#define MAX_MONITOR_REPORT 512
+
+// Progress of a run as last published by the scheduler, read by a sampler thread that rewrites a
+// stats file and answers connections on a Unix socket. The scheduler only stores counters; the
+// sampler does the formatting and the I/O.
+typedef struct Monitor {
+    char* path; // file rewritten every interval, or NULL
+    char* socket_path; // Unix socket serving a snapshot to each connection, or NULL
+    int interval; // in milliseconds, between samples
+    int listen_fd;
+    int wake_fd[2]; // written to stop the sampler
+    pthread_t thread;
+    MemoryStrategy strategy;
+    int num_processes;
+
+    // Published by the scheduler. seq is odd while an update is being written, so the sampler
+    // can retry a torn read.
+    atomic_uint seq;
+    atomic_int simulation_time;
+    atomic_int completed;
+    atomic_int queued;
+    atomic_int kb_used; // first-fit
+    atomic_int frames_used; // paged and virtual
+    atomic_long steps;
+
+    // Sampler only. Rates are taken once an interval, and socket clients are given the last ones,
+    // so however often they connect the window stays the same.
+    struct timespec started;
+    struct timespec last_sampled;
+    long last_steps;
+    int last_time;
+    double steps_per_sec;
+    double time_per_sec;
+} Monitor;
+
+// A consistent copy of the counters the scheduler published
+typedef struct MonitorSnapshot {
+    int simulation_time;
+    int completed;
+    int queued;
+    int kb_used;
+    int frames_used;
+    long steps;
+} MonitorSnapshot;
+
+void start_monitor(Monitor* monitor, char* path, char* socket_path, int interval, ProcessManager* pm,
+    MemoryStrategy strategy);
+void stop_monitor(Monitor* monitor, ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
+
+// Called once per scheduler step, so it is only a handful of stores
+static inline void publish_progress(Monitor* monitor, ProcessManager* pm, MemoryManager* mm, FrameManager* fm,
+    int queued) {
+    unsigned seq = atomic_load_explicit(&monitor->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&monitor->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&monitor->simulation_time, pm->simulation_time, memory_order_relaxed);
+    atomic_store_explicit(&monitor->completed, pm->completed_processes, memory_order_relaxed);
+    atomic_store_explicit(&monitor->queued, queued, memory_order_relaxed);
+    atomic_store_explicit(&monitor->kb_used, MAX_KB_AVAILABLE - mm->mem_available, memory_order_relaxed);
+    atomic_store_explicit(&monitor->frames_used, fm->frames_in_use, memory_order_relaxed);
+    atomic_store_explicit(&monitor->steps, atomic_load_explicit(&monitor->steps, memory_order_relaxed) + 1,
+        memory_order_relaxed);
+    atomic_store_explicit(&monitor->seq, seq + 2, memory_order_release);
+}
+
+#endif // MONITOR_H
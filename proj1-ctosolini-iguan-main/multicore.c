@@ -0,0 +1,406 @@
+#include <unistd.h>
+#include "multicore.h"
+
+// Per-core run queues for the multi-core scheduler. Arrivals are dealt round-robin across the
+// cores, each core runs its own queue round-robin, and a core with nothing runnable steals from
+// the tail of a randomly chosen busy core. All operations are O(1) apart from queue growth.
+//
+// The work of a step that only touches one core and its process is split across host threads,
+// each owning a fixed range of cores, between barriers. Everything that touches shared state
+// (memory, stealing, output) is left to the calling thread, which visits cores in index order,
+// so the output does not depend on the number of threads.
+
+static void deque_push_tail(RunDeque* dq, int process_index);
+static int deque_pop_head(RunDeque* dq);
+static int deque_pop_tail(RunDeque* dq);
+static unsigned long long next_random(CoreSet* cs);
+static void* worker_loop(void* arg);
+static void run_worker(Worker* w);
+static void requeue_cores(Worker* w);
+static void claim_cores(Worker* w);
+static void run_cores(Worker* w);
+
+void init_cores(CoreSet* cs, ProcessManager* pm, int num_cores, int num_threads, int migration_cost,
+    unsigned long long seed) {
+
+    cs->cores = (Core*) malloc(num_cores * sizeof(Core));
+    if (!cs->cores) {
+        perror("Error: Could not allocate memory for cores.");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < num_cores; c++) {
+        Core* core = &cs->cores[c];
+        core->ready.arr = (int*) malloc(INIT_DEQUE_CAPACITY * sizeof(int));
+        if (!core->ready.arr) {
+            perror("Error: Could not allocate memory for a core run queue.");
+            exit(EXIT_FAILURE);
+        }
+        core->ready.head = 0;
+        core->ready.size = 0;
+        core->ready.capacity = INIT_DEQUE_CAPACITY;
+        core->current = NOT_INTERRUPTED;
+        core->previous = NOT_INTERRUPTED;
+        core->pending = 0;
+        core->fresh = 0;
+        core->stall = 0;
+        core->busy_quanta = 0;
+        core->steals = 0;
+        core->migrations = 0;
+    }
+
+    cs->num_cores = num_cores;
+    cs->next_core = 0;
+    cs->queued = 0;
+    cs->batch = (Process**) malloc(num_cores * sizeof(Process*));
+    cs->batch_cores = (int*) malloc(num_cores * sizeof(int));
+    if (!cs->batch || !cs->batch_cores) {
+        perror("Error: Could not allocate memory for the dispatch batch.");
+        exit(EXIT_FAILURE);
+    }
+    cs->migration_cost = migration_cost;
+    cs->rng_state = seed;
+
+    // Each host thread takes an equal share of the cores; the calling thread is worker 0. A step
+    // waits on six barriers, which only pays off when every thread has thousands of cores to
+    // simulate, and a thread without a processor of its own only adds to the waits. So unless a
+    // number is asked for, there is a thread for every MIN_CORES_PER_THREAD cores, up to one per
+    // host processor.
+    if (num_threads == AUTO_THREADS) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = num_cores / MIN_CORES_PER_THREAD;
+        if (processors > 0 && num_threads > processors) {
+            num_threads = processors;
+        }
+    }
+    cs->num_threads = num_threads < num_cores ? num_threads : num_cores;
+    if (cs->num_threads < 1) {
+        cs->num_threads = 1;
+    }
+    cs->workers = (Worker*) malloc(cs->num_threads * sizeof(Worker));
+    if (!cs->workers) {
+        perror("Error: Could not allocate memory for worker threads.");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < cs->num_threads; t++) {
+        Worker* w = &cs->workers[t];
+        w->cs = cs;
+        w->pm = pm;
+        w->lo = (long) t * num_cores / cs->num_threads;
+        w->hi = (long) (t + 1) * num_cores / cs->num_threads;
+        w->dispatch = (int*) malloc((w->hi - w->lo) * sizeof(int));
+        w->fresh = (int*) malloc((w->hi - w->lo) * sizeof(int));
+        w->finished = (int*) malloc((w->hi - w->lo) * sizeof(int));
+        if (!w->dispatch || !w->fresh || !w->finished) {
+            perror("Error: Could not allocate memory for worker threads.");
+            exit(EXIT_FAILURE);
+        }
+        w->num_dispatch = w->num_fresh = w->num_finished = 0;
+    }
+
+    if (cs->num_threads > 1) {
+        pthread_barrier_init(&cs->phase_start, NULL, cs->num_threads);
+        pthread_barrier_init(&cs->phase_done, NULL, cs->num_threads);
+        for (int t = 1; t < cs->num_threads; t++) {
+            if (pthread_create(&cs->workers[t].thread, NULL, worker_loop, &cs->workers[t]) != 0) {
+                perror("Error: Could not start worker thread.");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+// Run one phase over every core, spread across the workers, and fold their results into the
+// core set. Returns the number of cores with a process.
+int run_phase(CoreSet* cs, StepPhase phase) {
+
+    cs->phase = phase;
+    if (cs->num_threads > 1) {
+        pthread_barrier_wait(&cs->phase_start);
+        run_worker(&cs->workers[0]);
+        pthread_barrier_wait(&cs->phase_done);
+    } else {
+        run_worker(&cs->workers[0]);
+    }
+
+    int busy = 0;
+    for (int t = 0; t < cs->num_threads; t++) {
+        cs->queued += cs->workers[t].queued_delta;
+        busy += cs->workers[t].busy;
+    }
+    return busy;
+}
+
+// Move the processes that arrived into the shared queue onto the cores, in arrival order
+void distribute_arrivals(CoreSet* cs, ProcessManager* pm) {
+
+    while (!is_scheduler_empty(&pm->current_processes)) {
+        push_ready(cs, cs->next_core, dequeue(&pm->current_processes));
+        cs->next_core = (cs->next_core + 1) % cs->num_cores;
+    }
+}
+
+void push_ready(CoreSet* cs, int core, int process_index) {
+
+    deque_push_tail(&cs->cores[core].ready, process_index);
+    cs->queued++;
+}
+
+// Next process in the core's own queue, or NOT_INTERRUPTED if it is empty
+int take_ready(CoreSet* cs, int core) {
+
+    int process_index = deque_pop_head(&cs->cores[core].ready);
+    if (process_index != NOT_INTERRUPTED) {
+        cs->queued--;
+    }
+    return process_index;
+}
+
+// The process take_ready would return, left in the queue
+int peek_ready(CoreSet* cs, int core) {
+
+    RunDeque* dq = &cs->cores[core].ready;
+    return dq->size > 0 ? dq->arr[dq->head] : NOT_INTERRUPTED;
+}
+
+// Take the most recently queued process of a random other core, or NOT_INTERRUPTED
+int steal_ready(CoreSet* cs, int thief) {
+
+    if (cs->queued == 0 || cs->num_cores == 1) {
+        return NOT_INTERRUPTED;
+    }
+    for (int attempt = 0; attempt < STEAL_ATTEMPTS; attempt++) {
+        int victim = next_random(cs) % (cs->num_cores - 1);
+        if (victim >= thief) {
+            victim++;
+        }
+        int process_index = deque_pop_tail(&cs->cores[victim].ready);
+        if (process_index != NOT_INTERRUPTED) {
+            cs->queued--;
+            return process_index;
+        }
+    }
+    return NOT_INTERRUPTED;
+}
+
+// Put a process on a core for this step. A process resuming on a different core than it last
+// ran on stalls while it warms up the core.
+void claim_process(CoreSet* cs, ProcessManager* pm, int core, int process_index) {
+
+    Process* process = &pm->processes[process_index];
+    if (process->last_core != NO_CORE && process->last_core != core) {
+        charge_stall(cs, pm, core, cs->migration_cost);
+        cs->cores[core].migrations++;
+    }
+    process->last_core = core;
+    process->status = RUNNING;
+    cs->cores[core].current = process_index;
+    cs->cores[core].pending = 1;
+    cs->cores[core].fresh = 1;
+    pm->last_used_times[process_index] = pm->simulation_time;
+}
+
+// With one core a stall holds up the whole machine. Otherwise only the stalled core waits,
+// keeping its process, while the other cores run on.
+void charge_stall(CoreSet* cs, ProcessManager* pm, int core, int stall) {
+
+    if (cs->num_cores == 1) {
+        pm->simulation_time += stall;
+    } else {
+        cs->cores[core].stall += stall;
+    }
+}
+
+// Processes waiting to run, whether in the shared arrival queue or on a core
+int count_ready(ProcessManager* pm) {
+
+    return pm->current_processes.size + (pm->cores ? pm->cores->queued : 0);
+}
+
+void print_core_stats(CoreSet* cs, int simulation_time, int quantum) {
+
+    long busy_quanta = 0, steals = 0, migrations = 0;
+    for (int c = 0; c < cs->num_cores; c++) {
+        busy_quanta += cs->cores[c].busy_quanta;
+        steals += cs->cores[c].steals;
+        migrations += cs->cores[c].migrations;
+    }
+    double capacity = (double) cs->num_cores * simulation_time;
+
+    printf("CPU utilisation %.2f%%\n", capacity > 0 ? busy_quanta * quantum / capacity * 100 : 0);
+    printf("Steals %ld\n", steals);
+    printf("Migrations %ld\n", migrations);
+    printf("Migration time %ld\n", migrations * cs->migration_cost);
+}
+
+void free_cores(CoreSet* cs) {
+
+    if (cs->num_threads > 1) {
+        cs->phase = PHASE_EXIT;
+        pthread_barrier_wait(&cs->phase_start);
+        for (int t = 1; t < cs->num_threads; t++) {
+            pthread_join(cs->workers[t].thread, NULL);
+        }
+        pthread_barrier_destroy(&cs->phase_start);
+        pthread_barrier_destroy(&cs->phase_done);
+    }
+    for (int t = 0; t < cs->num_threads; t++) {
+        free(cs->workers[t].dispatch);
+        free(cs->workers[t].fresh);
+        free(cs->workers[t].finished);
+    }
+    free(cs->workers);
+    cs->workers = NULL;
+
+    for (int c = 0; c < cs->num_cores; c++) {
+        free(cs->cores[c].ready.arr);
+    }
+    free(cs->cores);
+    cs->cores = NULL;
+    free(cs->batch);
+    free(cs->batch_cores);
+}
+
+static void* worker_loop(void* arg) {
+
+    Worker* w = (Worker*) arg;
+    while (1) {
+        pthread_barrier_wait(&w->cs->phase_start);
+        if (w->cs->phase == PHASE_EXIT) {
+            return NULL;
+        }
+        run_worker(w);
+        pthread_barrier_wait(&w->cs->phase_done);
+    }
+}
+
+static void run_worker(Worker* w) {
+
+    w->queued_delta = 0;
+    w->busy = 0;
+    switch (w->cs->phase) {
+        case PHASE_REQUEUE:
+            requeue_cores(w);
+            break;
+        case PHASE_CLAIM:
+            claim_cores(w);
+            break;
+        case PHASE_RUN:
+            run_cores(w);
+            break;
+        default:
+            break;
+    }
+}
+
+static void requeue_cores(Worker* w) {
+
+    for (int c = w->lo; c < w->hi; c++) {
+        Core* core = &w->cs->cores[c];
+        core->previous = core->current;
+        if (core->current != NOT_INTERRUPTED && !core->pending) {
+            w->pm->processes[core->current].status = READY;
+            deque_push_tail(&core->ready, core->current);
+            w->queued_delta++;
+            core->current = NOT_INTERRUPTED;
+        }
+    }
+}
+
+// A stalled core keeps its process. Otherwise a core takes the head of its own queue if it
+// already has memory; allocating memory or stealing is left to the serial dispatch.
+static void claim_cores(Worker* w) {
+
+    w->num_dispatch = w->num_fresh = 0;
+    for (int c = w->lo; c < w->hi; c++) {
+        Core* core = &w->cs->cores[c];
+        core->fresh = 0;
+        if (core->pending) {
+            w->busy++;
+            continue;
+        }
+        w->fresh[w->num_fresh++] = c;
+        if (core->ready.size > 0 && w->pm->processes[core->ready.arr[core->ready.head]].memory_allocated) {
+            claim_process(w->cs, w->pm, c, deque_pop_head(&core->ready));
+            w->queued_delta--;
+            w->busy++;
+        } else {
+            w->dispatch[w->num_dispatch++] = c;
+        }
+    }
+}
+
+// Run the quantum for processes that do not finish in it; finishing frees memory and prints,
+// so those are left to the serial part
+static void run_cores(Worker* w) {
+
+    int quantum = w->pm->quantum;
+    w->num_finished = 0;
+    for (int c = w->lo; c < w->hi; c++) {
+        Core* core = &w->cs->cores[c];
+        if (core->current == NOT_INTERRUPTED) {
+            continue;
+        }
+        core->busy_quanta++;
+        if (core->stall >= quantum) {
+            core->stall -= quantum;
+            continue;
+        }
+        core->pending = 0;
+        Process* process = &w->pm->processes[core->current];
+        if (process->remaining_time > quantum) {
+            process->remaining_time -= quantum;
+        } else {
+            w->finished[w->num_finished++] = c;
+        }
+    }
+}
+
+static void deque_push_tail(RunDeque* dq, int process_index) {
+
+    if (dq->size == dq->capacity) {
+        // Unroll the ring into a buffer twice the size
+        int* arr = (int*) malloc(2 * dq->capacity * sizeof(int));
+        if (!arr) {
+            perror("Error: Could not grow a core run queue.");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < dq->size; i++) {
+            arr[i] = dq->arr[(dq->head + i) % dq->capacity];
+        }
+        free(dq->arr);
+        dq->arr = arr;
+        dq->head = 0;
+        dq->capacity *= 2;
+    }
+    dq->arr[(dq->head + dq->size) % dq->capacity] = process_index;
+    dq->size++;
+}
+
+static int deque_pop_head(RunDeque* dq) {
+
+    if (dq->size == 0) {
+        return NOT_INTERRUPTED;
+    }
+    int process_index = dq->arr[dq->head];
+    dq->head = (dq->head + 1) % dq->capacity;
+    dq->size--;
+    return process_index;
+}
+
+static int deque_pop_tail(RunDeque* dq) {
+
+    if (dq->size == 0) {
+        return NOT_INTERRUPTED;
+    }
+    dq->size--;
+    return dq->arr[(dq->head + dq->size) % dq->capacity];
+}
+
+// splitmix64
+static unsigned long long next_random(CoreSet* cs) {
+
+    unsigned long long z = (cs->rng_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
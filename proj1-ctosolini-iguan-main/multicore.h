@@ -0,0 +1,88 @@
+#ifndef MULTICORE_H
+#define MULTICORE_H
+#include <pthread.h>
+#include "process.h"
+
+#define DEFAULT_MIGRATION_COST 1 // stall for a process each time it resumes on another core
+#define STEAL_ATTEMPTS 4 // random victims an idle core probes per step
+#define INIT_DEQUE_CAPACITY 16
+#define MIN_CORES_PER_THREAD 4096 // below this a thread's share of a phase costs less than the barriers around it
+#define AUTO_THREADS 0 // no -t: host threads are chosen from the number of cores
+
+// Growable ring buffer of process indices: the owner takes from the head, thieves from the tail
+typedef struct {
+    int* arr;
+    int head;
+    int size;
+    int capacity;
+} RunDeque;
+
+typedef struct {
+    RunDeque ready;
+    int current; // process on the core this step, or NOT_INTERRUPTED
+    int previous; // process the core ran last step, to print only changes of process
+    int pending; // current was dispatched but has not run its quantum yet
+    int fresh; // current was dispatched this step
+    int stall; // time the core must wait before current runs; whole quanta are waited out
+    long busy_quanta;
+    long steals;
+    long migrations;
+} Core;
+
+// Phases of a step that only touch the cores in a worker's range and the processes on them
+typedef enum {
+    PHASE_REQUEUE, // put back the processes interrupted by the last quantum
+    PHASE_CLAIM, // take the next process if it already has memory, otherwise leave the core for dispatch
+    PHASE_RUN, // run the quantum, leaving the processes that finish for the serial part
+    PHASE_EXIT
+} StepPhase;
+
+// A host thread simulating a contiguous range of cores. Its lists hold cores in index order, so
+// walking the workers in order visits cores in the same order whatever the number of threads.
+typedef struct {
+    pthread_t thread;
+    struct CoreSet* cs;
+    ProcessManager* pm;
+    int lo; // cores [lo, hi)
+    int hi;
+    int* dispatch; // cores whose next process needs memory, or that have none and may steal
+    int num_dispatch;
+    int* fresh; // cores that claimed a process or were left for dispatch this step
+    int num_fresh;
+    int* finished; // cores whose process finishes this quantum
+    int num_finished;
+    int queued_delta; // change to the shared count of queued processes
+    int busy; // cores with a process this step
+} Worker;
+
+typedef struct CoreSet {
+    Core* cores;
+    int num_cores;
+    int next_core; // core the next arrival is queued on
+    int queued; // processes waiting in all per-core queues
+    Process** batch; // processes allocated or released together in the serial part of a step
+    int* batch_cores; // core of each process in batch, when dispatching
+    int migration_cost;
+    unsigned long long rng_state; // victim choice, so runs are reproducible for a given seed
+    Worker* workers;
+    int num_threads;
+    StepPhase phase;
+    pthread_barrier_t phase_start;
+    pthread_barrier_t phase_done;
+} CoreSet;
+
+void init_cores(CoreSet* cs, ProcessManager* pm, int num_cores, int num_threads, int migration_cost,
+    unsigned long long seed);
+int run_phase(CoreSet* cs, StepPhase phase);
+void distribute_arrivals(CoreSet* cs, ProcessManager* pm);
+void push_ready(CoreSet* cs, int core, int process_index);
+int take_ready(CoreSet* cs, int core);
+int peek_ready(CoreSet* cs, int core);
+int steal_ready(CoreSet* cs, int thief);
+void claim_process(CoreSet* cs, ProcessManager* pm, int core, int process_index);
+void charge_stall(CoreSet* cs, ProcessManager* pm, int core, int stall);
+int count_ready(ProcessManager* pm);
+void print_core_stats(CoreSet* cs, int simulation_time, int quantum);
+void free_cores(CoreSet* cs);
+
+#endif // MULTICORE_H
@@ -0,0 +1,191 @@
+#include "numa.h"
+
+// Multi-bank (NUMA) memory. Each process has a home bank, and memory placed in any other bank is
+// remote: a process with a fraction r of its memory remote stalls for remote_penalty * r per unit
+// of time it runs.
+
+int parse_placement_policy(const char* name, PlacementPolicy* placement) {
+
+    if (strcmp(name, "local") == 0) {
+        *placement = PLACE_LOCAL;
+    } else if (strcmp(name, "interleave") == 0) {
+        *placement = PLACE_INTERLEAVE;
+    } else if (strcmp(name, "spill") == 0) {
+        *placement = PLACE_SPILL;
+    } else {
+        return NOT_ALLOCATED;
+    }
+    return ALLOCATED;
+}
+
+void init_numa(NumaModel* numa, int num_banks, PlacementPolicy placement, double remote_penalty) {
+
+    memset(numa, 0, sizeof(NumaModel));
+    numa->num_banks = num_banks;
+    numa->placement = placement;
+    numa->remote_penalty = remote_penalty;
+    numa->bank_kb = MAX_KB_AVAILABLE / num_banks;
+    numa->bank_frames = TOTAL_FRAMES / num_banks;
+
+    // Frames are handed out in this order, so placement is decided once here
+    for (int home = 0; home < num_banks; home++) {
+        for (int i = 0; i < TOTAL_FRAMES; i++) {
+            int bank, offset;
+            switch (placement) {
+                case PLACE_LOCAL:
+                    bank = (home + i / numa->bank_frames) % num_banks;
+                    offset = i % numa->bank_frames;
+                    break;
+                case PLACE_INTERLEAVE:
+                    bank = i % num_banks;
+                    offset = i / num_banks;
+                    break;
+                case PLACE_SPILL:
+                default:
+                    bank = i / numa->bank_frames;
+                    offset = i % numa->bank_frames;
+                    break;
+            }
+            numa->frame_order[home][i] = bank * numa->bank_frames + offset;
+        }
+    }
+}
+
+// Home banks are spread round-robin over the processes in arrival order
+void assign_home_banks(NumaModel* numa, ProcessManager* pm) {
+
+    for (int i = 0; i < pm->num_processes; i++) {
+        pm->processes[i].home_bank = i % numa->num_banks;
+    }
+}
+
+// Replace the single initial hole with one hole per bank, so holes never merge across banks
+void split_memory_banks(NumaModel* numa, MemoryManager* mm) {
+
+    MemoryAddress* prev = mm->head;
+    prev->length = numa->bank_kb;
+
+    for (int bank = 1; bank < numa->num_banks; bank++) {
+        MemoryAddress* hole = (MemoryAddress*) malloc(sizeof(MemoryAddress));
+        assert(hole != NULL);
+        hole->use = HOLE;
+        hole->starting_address = bank * numa->bank_kb;
+        hole->length = numa->bank_kb;
+        hole->nxt = NULL;
+        hole->prev = prev;
+        prev->nxt = hole;
+        prev = hole;
+    }
+    mm->tail = prev;
+}
+
+// Banks a contiguous allocation tries, in order
+void bank_order(NumaModel* numa, int home, int order[]) {
+
+    int first;
+    switch (numa->placement) {
+        case PLACE_LOCAL:
+            first = home;
+            break;
+        case PLACE_INTERLEAVE:
+            first = numa->next_bank;
+            break;
+        case PLACE_SPILL:
+        default:
+            first = 0;
+            break;
+    }
+    for (int i = 0; i < numa->num_banks; i++) {
+        order[i] = (first + i) % numa->num_banks;
+    }
+}
+
+int is_bank_start(NumaModel* numa, int address) {
+
+    return address % numa->bank_kb == 0;
+}
+
+int bank_free_kb(MemoryManager* mm, int bank) {
+
+    int lo = bank * mm->numa->bank_kb;
+    int hi = lo + mm->numa->bank_kb;
+    int free_kb = 0;
+
+    for (MemoryAddress* curr = mm->head; curr && curr->starting_address < hi; curr = curr->nxt) {
+        if (curr->use == HOLE && curr->starting_address >= lo) {
+            free_kb += curr->length;
+        }
+    }
+    return free_kb;
+}
+
+// Record where a process's memory was placed; the stall is charged as it runs
+void apply_remote_penalty(NumaModel* numa, Process* process, int bank, int local_units, int remote_units) {
+
+    if (bank != NOT_IN_USE) {
+        numa->allocations[bank]++;
+        if (numa->placement == PLACE_INTERLEAVE) {
+            numa->next_bank = (bank + 1) % numa->num_banks;
+        }
+    }
+    numa->local_units += local_units;
+    numa->remote_units += remote_units;
+    process->remote_fraction = local_units + remote_units > 0 ?
+        (double) remote_units / (local_units + remote_units) : 0;
+}
+
+void apply_frame_penalty(NumaModel* numa, Process* process) {
+
+    int local_frames = 0;
+    int touched[MAX_BANKS] = {0};
+
+    for (int i = 0; i < process->num_frames; i++) {
+        int bank = process->frames[i] / numa->bank_frames;
+        touched[bank] = 1;
+        if (bank == process->home_bank) {
+            local_frames++;
+        }
+    }
+    for (int bank = 0; bank < numa->num_banks; bank++) {
+        numa->allocations[bank] += touched[bank];
+    }
+    apply_remote_penalty(numa, process, NOT_IN_USE, local_frames, process->num_frames - local_frames);
+}
+
+// Whole units of stall for running one quantum, carrying any fraction to the next quantum
+int charge_remote_access(NumaModel* numa, Process* process, int quantum) {
+
+    numa->penalty_debt += quantum * numa->remote_penalty * process->remote_fraction;
+    int charge = (int) numa->penalty_debt;
+    numa->penalty_debt -= charge;
+    numa->penalty_time += charge;
+    return charge;
+}
+
+// Integrate each bank's usage since the last sample, then take the current usage
+void sample_numa(NumaModel* numa, int simulation_time) {
+
+    for (int bank = 0; bank < numa->num_banks; bank++) {
+        numa->usage_integral[bank] += (double) numa->used[bank] * (simulation_time - numa->last_sample_time);
+        numa->used[bank] = numa->in_use[bank];
+        if (numa->used[bank] > numa->peak[bank]) {
+            numa->peak[bank] = numa->used[bank];
+        }
+    }
+    numa->last_sample_time = simulation_time;
+}
+
+void print_numa_stats(NumaModel* numa, MemoryStrategy strategy) {
+
+    int capacity = strategy == FIRST_FIT ? numa->bank_kb : numa->bank_frames;
+    long total_units = numa->local_units + numa->remote_units;
+
+    for (int bank = 0; bank < numa->num_banks; bank++) {
+        double average = numa->last_sample_time > 0 ?
+            numa->usage_integral[bank] / numa->last_sample_time / capacity * 100 : 0;
+        printf("Bank %d usage %.2f%% peak %.2f%% allocations %ld\n", bank, average,
+            (double) numa->peak[bank] / capacity * 100, numa->allocations[bank]);
+    }
+    printf("Remote memory %.2f%%\n", total_units ? (double) numa->remote_units / total_units * 100 : 0);
+    printf("Remote penalty time %d\n", numa->penalty_time);
+}
@@ -0,0 +1,70 @@
+#ifndef NUMA_H
+#define NUMA_H
+#include "paged_allocation.h"
+
+#define MAX_BANKS 64
+#define DEFAULT_REMOTE_PENALTY 0.5 // stall per unit of run time for a process with all of its memory remote
+
+typedef enum {
+    PLACE_LOCAL, // the process's home bank first, then the banks after it
+    PLACE_INTERLEAVE, // frames round-robin across banks; contiguous blocks rotate their starting bank
+    PLACE_SPILL // fill bank 0 first and spill into the next bank when full, ignoring locality
+} PlacementPolicy;
+
+// Memory split into equal banks. First-fit blocks and paged frames never cross a bank boundary.
+typedef struct NumaModel {
+    int num_banks;
+    PlacementPolicy placement;
+    double remote_penalty;
+    int bank_kb; // KB per bank
+    int bank_frames; // frames per bank
+    int next_bank; // interleave: bank tried first by the next contiguous allocation
+    int frame_order[MAX_BANKS][TOTAL_FRAMES]; // order frames are handed out, per home bank
+
+    // Usage in KB (first-fit) or frames (paged, virtual), kept up to date as memory is taken and
+    // given back
+    int in_use[MAX_BANKS];
+
+    // Statistics, with usage sampled from in_use each quantum
+    int used[MAX_BANKS];
+    int peak[MAX_BANKS];
+    double usage_integral[MAX_BANKS];
+    int last_sample_time;
+    long allocations[MAX_BANKS];
+    long local_units;
+    long remote_units;
+    double penalty_debt; // fraction of a time unit of stall not yet charged
+    int penalty_time;
+} NumaModel;
+
+int parse_placement_policy(const char* name, PlacementPolicy* placement);
+void init_numa(NumaModel* numa, int num_banks, PlacementPolicy placement, double remote_penalty);
+void assign_home_banks(NumaModel* numa, ProcessManager* pm);
+void split_memory_banks(NumaModel* numa, MemoryManager* mm);
+void bank_order(NumaModel* numa, int home, int order[]);
+int is_bank_start(NumaModel* numa, int address);
+int bank_free_kb(MemoryManager* mm, int bank);
+void apply_remote_penalty(NumaModel* numa, Process* process, int bank, int local_units, int remote_units);
+void apply_frame_penalty(NumaModel* numa, Process* process);
+int charge_remote_access(NumaModel* numa, Process* process, int quantum);
+void sample_numa(NumaModel* numa, int simulation_time);
+void print_numa_stats(NumaModel* numa, MemoryStrategy strategy);
+
+// Count a first-fit block of kb starting at address as taken (kb > 0) or given back (kb < 0)
+static inline void count_bank_kb(MemoryManager* mm, int address, int kb) {
+
+    if (mm->numa) {
+        mm->numa->in_use[address / mm->numa->bank_kb] += kb;
+    }
+}
+
+// Count a frame about to be set to the given state; frames already in that state do not change
+// the count
+static inline void count_bank_frame(FrameManager* fm, int frame, int is_allocated) {
+
+    if (fm->numa && fm->frames[frame].is_allocated != is_allocated) {
+        fm->numa->in_use[frame / fm->numa->bank_frames] += is_allocated == ALLOCATED ? 1 : -1;
+    }
+}
+
+#endif // NUMA_H
@@ -0,0 +1,342 @@
+#include "page_replacement.h"
+#include "swap.h"
+#include "numa.h"
+
+// Page-granular replacement for virtual memory. Each resident frame records its owner and a
+// reference bit that is set whenever the owner runs a quantum. Victims are single frames chosen
+// by the selected policy, rather than whole-process prefixes chosen by process-level recency.
+
+static void list_append(FrameManager* fm, int frame_index);
+static void list_remove(FrameManager* fm, int frame_index);
+static int is_pinned(FrameManager* fm, ProcessManager* pm, int frame_index, int cur);
+static int victim_lru(FrameManager* fm, ProcessManager* pm, int cur);
+static int victim_second_chance(FrameManager* fm, ProcessManager* pm, int cur);
+static int victim_clock(FrameManager* fm, ProcessManager* pm, int cur);
+static int victim_wsclock(FrameManager* fm, ProcessManager* pm, int cur);
+static int compare_frame_index(const void* a, const void* b);
+
+int parse_replacement_policy(const char* name, ReplacementPolicy* policy) {
+
+    if (strcmp(name, "lru") == 0) {
+        *policy = REPLACE_LRU;
+    } else if (strcmp(name, "clock") == 0) {
+        *policy = REPLACE_CLOCK;
+    } else if (strcmp(name, "second-chance") == 0) {
+        *policy = REPLACE_SECOND_CHANCE;
+    } else if (strcmp(name, "wsclock") == 0) {
+        *policy = REPLACE_WSCLOCK;
+    } else {
+        return NOT_ALLOCATED;
+    }
+    return ALLOCATED;
+}
+
+// A process can run once MIN_PAGE_ALLOCATION of its pages are resident (or all of them, if it
+// has fewer). Free frames are used first, then single frames of other processes are evicted.
+int allocate_virtual_pages(FrameManager* fm, ProcessManager* pm, Process* process_to_allocate) {
+
+    int total_required = ceil((double) process_to_allocate->memory_requirement / FRAME_SIZE);
+    int min_requirement = total_required < MIN_PAGE_ALLOCATION ? total_required : MIN_PAGE_ALLOCATION;
+
+    if (process_to_allocate->page_table == NULL) {
+        process_to_allocate->page_table = (int*) malloc(total_required * sizeof(int));
+        process_to_allocate->frames = (int*) malloc(total_required * sizeof(int));
+        if (!process_to_allocate->page_table || !process_to_allocate->frames) {
+            perror("Error: Could not allocate page table of a process.");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < total_required; i++) {
+            process_to_allocate->page_table[i] = NOT_IN_USE;
+        }
+        process_to_allocate->num_pages = total_required;
+        process_to_allocate->num_frames = 0;
+    }
+
+    int target = process_to_allocate->num_frames + (TOTAL_FRAMES - fm->frames_in_use);
+    if (target > total_required) {
+        target = total_required;
+    }
+
+    int evicted[TOTAL_FRAMES];
+    int num_evicted = 0;
+    int out_of_swap = 0;
+    while (target < min_requirement) {
+        int victim = select_victim_frame(fm, pm, process_to_allocate);
+        if (victim == NOT_IN_USE) {
+            return NOT_ALLOCATED;
+        }
+        if (fm->swap && fm->swap->full_policy == SWAP_FULL_KILL && swap_full(fm->swap)) {
+            out_of_swap = 1;
+            break;
+        }
+        evict_frame(fm, pm, victim);
+        evicted[num_evicted++] = victim;
+        target++;
+    }
+
+    if (out_of_swap) {
+        print_evicted_frames(pm, evicted, num_evicted);
+        kill_process(fm, pm, process_to_allocate);
+        return NOT_ALLOCATED;
+    }
+
+    // Load the lowest non-resident pages into the first free frames, in one pass over each
+    int i = 0;
+    for (int page = 0; page < process_to_allocate->num_pages && process_to_allocate->num_frames < target; page++) {
+        if (process_to_allocate->page_table[page] != NOT_IN_USE) {
+            continue;
+        }
+        while (fm->frames[frame_in_order(fm, process_to_allocate, i)].is_allocated == ALLOCATED) {
+            i++;
+        }
+        load_page(fm, pm, process_to_allocate, page, frame_in_order(fm, process_to_allocate, i));
+    }
+
+    print_evicted_frames(pm, evicted, num_evicted);
+
+    return ALLOCATED;
+}
+
+// Called once per quantum for the process about to run: all of its resident pages are referenced.
+void touch_frames(FrameManager* fm, Process* process, int simulation_time) {
+
+    for (int i = 0; i < process->num_frames; i++) {
+        touch_frame(fm, process->frames[i], simulation_time);
+    }
+}
+
+void touch_frame(FrameManager* fm, int frame_index, int simulation_time) {
+
+    fm->frames[frame_index].referenced = 1;
+    fm->frames[frame_index].last_used_time = simulation_time;
+
+    if (fm->policy == REPLACE_LRU) {
+        // Most recently used frames live at the tail
+        list_remove(fm, frame_index);
+        list_append(fm, frame_index);
+    }
+}
+
+int select_victim_frame(FrameManager* fm, ProcessManager* pm, Process* process_to_allocate) {
+
+    int cur = process_to_allocate - pm->processes;
+
+    switch (fm->policy) {
+        case REPLACE_LRU:
+            return victim_lru(fm, pm, cur);
+        case REPLACE_SECOND_CHANCE:
+            return victim_second_chance(fm, pm, cur);
+        case REPLACE_CLOCK:
+            return victim_clock(fm, pm, cur);
+        case REPLACE_WSCLOCK:
+            return victim_wsclock(fm, pm, cur);
+        default:
+            fprintf(stderr, "Unsupported page replacement policy\n");
+            exit(EXIT_FAILURE);
+    }
+}
+
+// Release a single frame, removing the page from its owner's page table and frame list
+void evict_frame(FrameManager* fm, ProcessManager* pm, int frame_index) {
+
+    Frame* frame = &fm->frames[frame_index];
+    Process* owner = &pm->processes[frame->owner];
+
+    owner->page_table[frame->page_number] = NOT_IN_USE;
+    if (fm->swap) {
+        swap_out(fm->swap, frame->owner, frame->page_number);
+    }
+    for (int i = 0; i < owner->num_frames; i++) {
+        if (owner->frames[i] == frame_index) {
+            memmove(owner->frames + i, owner->frames + i + 1, (owner->num_frames - i - 1) * sizeof(int));
+            break;
+        }
+    }
+    owner->num_frames--;
+
+    // The owner can no longer run until it is topped back up to its minimum
+    int owner_min = owner->num_pages < MIN_PAGE_ALLOCATION ? owner->num_pages : MIN_PAGE_ALLOCATION;
+    if (owner->num_frames < owner_min) {
+        owner->memory_allocated = NOT_ALLOCATED;
+    }
+
+    list_remove(fm, frame_index);
+    count_bank_frame(fm, frame_index, NOT_ALLOCATED);
+    release_frame(frame);
+    fm->frames_in_use--;
+    fm->page_evictions++;
+}
+
+void load_page(FrameManager* fm, ProcessManager* pm, Process* process, int page, int frame_index) {
+
+    Frame* frame = &fm->frames[frame_index];
+
+    if (fm->swap) {
+        swap_in(fm->swap, process - pm->processes, page);
+    }
+    count_bank_frame(fm, frame_index, ALLOCATED);
+    frame->is_allocated = ALLOCATED;
+    frame->page_number = page;
+    frame->owner = process - pm->processes;
+    frame->referenced = 0;
+    frame->last_used_time = pm->simulation_time;
+    list_append(fm, frame_index);
+    fm->frames_in_use++;
+
+    process->page_table[page] = frame_index;
+    process->frames[process->num_frames++] = frame_index;
+}
+
+// Release every resident page of a finished process
+void release_pages(FrameManager* fm, Process* process) {
+
+    for (int i = 0; i < process->num_frames; i++) {
+        list_remove(fm, process->frames[i]);
+        count_bank_frame(fm, process->frames[i], NOT_ALLOCATED);
+        release_frame(&fm->frames[process->frames[i]]);
+        fm->frames_in_use--;
+    }
+    process->num_frames = 0;
+    if (fm->swap) {
+        release_swap(fm->swap, process);
+    }
+
+    free(process->page_table);
+    process->page_table = NULL;
+}
+
+void print_replacement_stats(FrameManager* fm) {
+
+    if (fm->policy != REPLACE_PROCESS) {
+        printf("Page evictions %d\n", fm->page_evictions);
+    }
+}
+
+static void list_append(FrameManager* fm, int frame_index) {
+
+    fm->list_prev[frame_index] = fm->list_tail;
+    fm->list_next[frame_index] = NOT_IN_USE;
+    if (fm->list_tail != NOT_IN_USE) {
+        fm->list_next[fm->list_tail] = frame_index;
+    } else {
+        fm->list_head = frame_index;
+    }
+    fm->list_tail = frame_index;
+}
+
+static void list_remove(FrameManager* fm, int frame_index) {
+
+    int prev = fm->list_prev[frame_index];
+    int next = fm->list_next[frame_index];
+
+    if (prev != NOT_IN_USE) {
+        fm->list_next[prev] = next;
+    } else {
+        fm->list_head = next;
+    }
+    if (next != NOT_IN_USE) {
+        fm->list_prev[next] = prev;
+    } else {
+        fm->list_tail = prev;
+    }
+    fm->list_prev[frame_index] = fm->list_next[frame_index] = NOT_IN_USE;
+}
+
+// Frames of the process being allocated, or of one running on another core, cannot be evicted
+static int is_pinned(FrameManager* fm, ProcessManager* pm, int frame_index, int cur) {
+
+    int owner = fm->frames[frame_index].owner;
+    return owner == cur || pm->processes[owner].status == RUNNING;
+}
+
+// Least recently used frame sits at the head of the recency list
+static int victim_lru(FrameManager* fm, ProcessManager* pm, int cur) {
+
+    for (int f = fm->list_head; f != NOT_IN_USE; f = fm->list_next[f]) {
+        if (!is_pinned(fm, pm, f, cur)) {
+            return f;
+        }
+    }
+    return NOT_IN_USE;
+}
+
+// FIFO by load order, but a referenced frame has its bit cleared and goes to the back of the queue.
+// A pinned frame goes to the back as it is, since its owner is using it.
+static int victim_second_chance(FrameManager* fm, ProcessManager* pm, int cur) {
+
+    // Every frame is rotated at most twice: once to clear its bit, once to be chosen
+    for (int inspected = 0; inspected < 2 * fm->frames_in_use; inspected++) {
+        int f = fm->list_head;
+        if (!is_pinned(fm, pm, f, cur)) {
+            if (!fm->frames[f].referenced) {
+                return f;
+            }
+            fm->frames[f].referenced = 0;
+        }
+        list_remove(fm, f);
+        list_append(fm, f);
+    }
+    return NOT_IN_USE;
+}
+
+// Clock hand sweeps the frame table, clearing reference bits until it finds an unreferenced frame
+static int victim_clock(FrameManager* fm, ProcessManager* pm, int cur) {
+
+    for (int inspected = 0; inspected < 2 * TOTAL_FRAMES; inspected++) {
+        int f = fm->clock_hand;
+        fm->clock_hand = (fm->clock_hand + 1) % TOTAL_FRAMES;
+
+        if (fm->frames[f].is_allocated == NOT_ALLOCATED || is_pinned(fm, pm, f, cur)) {
+            continue;
+        }
+        if (!fm->frames[f].referenced) {
+            return f;
+        }
+        fm->frames[f].referenced = 0;
+    }
+    return NOT_IN_USE;
+}
+
+// As clock, but an unreferenced frame is only taken once it has aged out of the working set.
+// If a full sweep finds none, the oldest unreferenced frame seen is taken instead.
+static int victim_wsclock(FrameManager* fm, ProcessManager* pm, int cur) {
+
+    int oldest = NOT_IN_USE;
+
+    for (int inspected = 0; inspected < 2 * TOTAL_FRAMES; inspected++) {
+        int f = fm->clock_hand;
+        fm->clock_hand = (fm->clock_hand + 1) % TOTAL_FRAMES;
+
+        if (fm->frames[f].is_allocated == NOT_ALLOCATED || is_pinned(fm, pm, f, cur)) {
+            continue;
+        }
+        if (fm->frames[f].referenced) {
+            fm->frames[f].referenced = 0;
+            continue;
+        }
+        if (pm->simulation_time - fm->frames[f].last_used_time > fm->working_set_window) {
+            return f;
+        }
+        if (oldest == NOT_IN_USE || fm->frames[f].last_used_time < fm->frames[oldest].last_used_time) {
+            oldest = f;
+        }
+        if (inspected >= TOTAL_FRAMES && oldest != NOT_IN_USE) {
+            break;
+        }
+    }
+    return oldest;
+}
+
+void print_evicted_frames(ProcessManager* pm, int evicted[], int num_evicted) {
+
+    if (num_evicted > 0) {
+        qsort(evicted, num_evicted, sizeof(int), compare_frame_index);
+        printf("%d,%s,evicted-frames=", pm->simulation_time, get_status_string(EVICTED));
+        print_mem_frames(evicted, num_evicted);
+    }
+}
+
+static int compare_frame_index(const void* a, const void* b) {
+
+    return *(const int*) a - *(const int*) b;
+}
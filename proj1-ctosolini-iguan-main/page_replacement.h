@@ -0,0 +1,18 @@
+#ifndef PAGE_REPLACEMENT_H
+#define PAGE_REPLACEMENT_H
+#include "virtual_allocation.h"
+
+#define DEFAULT_WORKING_SET_WINDOW 10 // wsclock: idle time (simulated) before a frame leaves the working set
+
+int parse_replacement_policy(const char* name, ReplacementPolicy* policy);
+int allocate_virtual_pages(FrameManager* fm, ProcessManager* pm, Process* process_to_allocate);
+void touch_frames(FrameManager* fm, Process* process, int simulation_time);
+void touch_frame(FrameManager* fm, int frame_index, int simulation_time);
+int select_victim_frame(FrameManager* fm, ProcessManager* pm, Process* process_to_allocate);
+void evict_frame(FrameManager* fm, ProcessManager* pm, int frame_index);
+void load_page(FrameManager* fm, ProcessManager* pm, Process* process, int page, int frame_index);
+void release_pages(FrameManager* fm, Process* process);
+void print_evicted_frames(ProcessManager* pm, int evicted[], int num_evicted);
+void print_replacement_stats(FrameManager* fm);
+
+#endif // PAGE_REPLACEMENT_H
@@ -1,5 +1,10 @@
 #include "paged_allocation.h"
+#include "groups.h"
+#include "numa.h"
 
+static void map_frame(FrameManager* fm, int frame, int page);
+static void unmap_frame(FrameManager* fm, int frame);
+static int compare_frame_number(const void* a, const void* b);
 
 void init_frames(FrameManager* fm) {
 
@@ -8,7 +13,33 @@ void init_frames(FrameManager* fm) {
 
         fm->frames[i].page_number = NOT_IN_USE;
         fm->frames[i].is_allocated = NOT_ALLOCATED;
+        fm->frames[i].last_used_time = NOT_IN_USE;
+        fm->frames[i].owner = NOT_IN_USE;
+        fm->frames[i].referenced = 0;
+        fm->list_prev[i] = fm->list_next[i] = NOT_IN_USE;
     }
+
+    fm->policy = REPLACE_PROCESS;
+    fm->clock_hand = 0;
+    fm->list_head = fm->list_tail = NOT_IN_USE;
+    fm->working_set_window = 0;
+    fm->page_evictions = 0;
+    fm->access_model = NULL;
+    fm->numa = NULL;
+    fm->swap = NULL;
+    fm->groups = NULL;
+
+    fm->superframe_frames = BASE_FRAMES_ONLY;
+    memset(fm->slot_used, 0, sizeof(fm->slot_used));
+    fm->padding_frames = fm->peak_padding_frames = 0;
+    fm->superframes_mapped = fm->promotions = fm->fallbacks = 0;
+    fm->entries_mapped = fm->frames_mapped = fm->padding_mapped = 0;
+}
+
+// The i-th frame to try when placing a process; with memory banks this depends on its home bank
+int frame_in_order(FrameManager* fm, Process* process, int i) {
+
+    return fm->numa ? fm->numa->frame_order[process->home_bank][i] : i;
 }
 
 int allocate_pages(FrameManager* fm, ProcessManager* pm, Process* process_to_allocate) {
@@ -29,42 +60,58 @@ int allocate_pages(FrameManager* fm, ProcessManager* pm, Process* process_to_all
     int max_allocatable = TOTAL_FRAMES - fm->frames_in_use;
     
     if (max_allocatable >= required_frames) {
+        if (fm->superframe_frames != BASE_FRAMES_ONLY) {
+            return allocate_superframes(fm, process_to_allocate, required_frames);
+        }
         return allocate_frames(fm, process_to_allocate, required_frames);
     } else {
         while (max_allocatable < required_frames) {
             Process* lru_process = find_lru_process(pm, process_to_allocate);
             if (lru_process == NULL) {
-                perror("No suitable LRU process found for eviction.\n");
+                // Every other resident process is running on another core
                 return NOT_ALLOCATED;
             }
             // evict frames in the LRU process
-            max_allocatable += lru_process->num_frames;
+            max_allocatable += frames_held(fm, lru_process);
             lru_process->memory_allocated = NOT_ALLOCATED;
-            print_eviction_notice(pm, lru_process);
+            print_eviction_notice(pm, fm, lru_process);
             release_frames(fm, lru_process);
+            if (fm->groups) {
+                uncharge_group(fm->groups, PAGED, lru_process);
+            }
         }
 
         
     }
 
+    if (fm->superframe_frames != BASE_FRAMES_ONLY) {
+        return allocate_superframes(fm, process_to_allocate, required_frames);
+    }
     return allocate_frames(fm, process_to_allocate, required_frames);
 }
 
-int allocate_frames(FrameManager* fm, Process* process, int required_pages) {
+// Give the process the free frames met from position *next of its frame order on, up to
+// required_pages of them, leaving *next after the last frame looked at
+static int take_free_frames(FrameManager* fm, Process* process, int required_pages, int* next) {
 
     int allocated = 0;
-    int i = 0;
-    while (i < TOTAL_FRAMES && allocated < required_pages) {
-        if (fm->frames[i].is_allocated == NOT_ALLOCATED) {
-            fm->frames[i].page_number = process->frames[allocated];
-            fm->frames[i].is_allocated = ALLOCATED;
-            process->frames[allocated] = i;
-            fm->frames_in_use++;
+    while (*next < TOTAL_FRAMES && allocated < required_pages) {
+        int f = frame_in_order(fm, process, *next);
+        if (fm->frames[f].is_allocated == NOT_ALLOCATED) {
+            map_frame(fm, f, allocated);
+            process->frames[allocated] = f;
             allocated++;
         }
-        i++;
+        (*next)++;
     }
     process->num_frames = allocated;
+    return allocated;
+}
+
+int allocate_frames(FrameManager* fm, Process* process, int required_pages) {
+
+    int next = 0;
+    int allocated = take_free_frames(fm, process, required_pages, &next);
     
     if (allocated < required_pages) {
         // release the frames that have been allocated
@@ -74,14 +121,49 @@ int allocate_frames(FrameManager* fm, Process* process, int required_pages) {
     return ALLOCATED; 
 }
 
+// Allocate frames to the processes in order, stopping at the first one that does not fit in the
+// free frames. Processes sharing a frame order continue one scan: every frame before where the
+// last of them stopped is in use, so each gets the frames allocate_pages would have given it.
+// Returns how many processes got their frames.
+int allocate_pages_batch(FrameManager* fm, Process** processes, int n) {
+
+    int next[MAX_BANKS] = {0};
+
+    for (int p = 0; p < n; p++) {
+        Process* process = processes[p];
+        int required_frames = ceil((double) process->memory_requirement / FRAME_SIZE);
+
+        if (TOTAL_FRAMES - fm->frames_in_use < required_frames) {
+            return p;
+        }
+        if (!process->frames) {
+            process->frames = (int*) malloc(required_frames * sizeof(int));
+            if (!process->frames) {
+                perror("Error: Could not allocate memory for frames array of a process.");
+                return p;
+            }
+        }
+        take_free_frames(fm, process, required_frames, &next[fm->numa ? process->home_bank : 0]);
+    }
+    return n;
+}
+
 void release_frames(FrameManager* fm, Process* process) {
 
+    if (process->num_superframes > 0) {
+        int required_frames = ceil((double) process->memory_requirement / FRAME_SIZE);
+        int padding = frames_held(fm, process) - required_frames;
+        fm->padding_frames -= padding > 0 ? padding : 0;
+    }
     for (int i = 0; i < process->num_frames; i++) {
-        release_frame(&fm->frames[process->frames[i]]);
-        fm->frames_in_use--;
+        int span = i < process->num_superframes ? fm->superframe_frames : 1;
+        for (int f = process->frames[i]; f < process->frames[i] + span; f++) {
+            unmap_frame(fm, f);
+        }
     }
     
     process->num_frames = 0;
+    process->num_superframes = 0;
 }
 
 void release_frame(Frame* frame) {
@@ -89,12 +171,175 @@ void release_frame(Frame* frame) {
     frame->page_number = NOT_IN_USE;
     frame->is_allocated = NOT_ALLOCATED;
     frame->last_used_time = NOT_IN_USE;
+    frame->owner = NOT_IN_USE;
+    frame->referenced = 0;
 }
 
-void print_eviction_notice(ProcessManager* pm, Process* process) {
+void print_eviction_notice(ProcessManager* pm, FrameManager* fm, Process* process) {
 
     printf("%d,%s,evicted-frames=", pm->simulation_time, get_status_string(EVICTED));
-    print_mem_frames(process->frames, process->num_frames);
+    print_process_frames(fm, process);
+}
+
+int parse_superframe_size(const char* arg, int* superframe_frames) {
+    int size = atoi(arg);
+
+    // Slots are aligned to their size, so the size must be a power of two that divides memory
+    if (size < 2 || size > TOTAL_FRAMES || (size & (size - 1)) != 0) {
+        return NOT_ALLOCATED;
+    }
+    *superframe_frames = size;
+    return ALLOCATED;
+}
+
+// Frames the process holds, counting each superframe in full
+int frames_held(FrameManager* fm, Process* process) {
+
+    return process->num_frames + process->num_superframes * (fm->superframe_frames - 1);
+}
+
+// Serve the process with superframes where whole aligned slots are free, and base frames for the
+// rest. A last partial superframe that is at least half used is rounded up to a whole one when
+// the padding fits in free memory. Base frames come from partly used slots first, to keep free
+// slots whole for later superframes. There must be enough free frames for the process.
+int allocate_superframes(FrameManager* fm, Process* process, int required_pages) {
+    int size = fm->superframe_frames;
+    int num_slots = TOTAL_FRAMES / size;
+    int wanted = required_pages / size;
+    int tail = required_pages % size;
+
+    if (wanted > 0 && 2 * tail >= size && TOTAL_FRAMES - fm->frames_in_use >= required_pages + size - tail) {
+        wanted++;
+    }
+
+    int entries = 0;
+    int page = 0;
+    for (int slot = 0; slot < num_slots && entries < wanted; slot++) {
+        if (fm->slot_used[slot] > 0) {
+            continue;
+        }
+        for (int f = slot * size; f < (slot + 1) * size; f++) {
+            map_frame(fm, f, page++);
+        }
+        process->frames[entries++] = slot * size;
+    }
+    process->num_superframes = entries;
+    fm->superframes_mapped += entries;
+    fm->fallbacks += wanted - entries;
+
+    for (int pass = 0; pass < 2 && page < required_pages; pass++) {
+        for (int f = 0; f < TOTAL_FRAMES && page < required_pages; f++) {
+            if (fm->frames[f].is_allocated == NOT_ALLOCATED && (pass == 1 || fm->slot_used[f / size] > 0)) {
+                map_frame(fm, f, page++);
+                process->frames[entries++] = f;
+            }
+        }
+    }
+    process->num_frames = entries;
+    if (page < required_pages) {
+        release_frames(fm, process);
+        return NOT_ALLOCATED;
+    }
+
+    int padding = page - required_pages;
+    fm->padding_frames += padding;
+    if (fm->padding_frames > fm->peak_padding_frames) {
+        fm->peak_padding_frames = fm->padding_frames;
+    }
+    fm->entries_mapped += entries;
+    fm->frames_mapped += page;
+    fm->padding_mapped += padding;
+    return ALLOCATED;
 }
 
+// Move base frames of a resident process into slots that have since come free, a superframe's
+// worth at a time. The base frames are kept in page order, so each superframe takes over the
+// highest pages still in base frames, a contiguous run.
+void promote_frames(FrameManager* fm, Process* process) {
+    int size = fm->superframe_frames;
+    int slot = 0;
+
+    while (process->num_frames - process->num_superframes >= size) {
+        while (slot < TOTAL_FRAMES / size && fm->slot_used[slot] > 0) {
+            slot++;
+        }
+        if (slot == TOTAL_FRAMES / size) {
+            return;
+        }
+
+        // The last base frames make way for the superframe, whose entry goes before the others
+        process->num_frames -= size;
+        for (int i = 0; i < size; i++) {
+            int f = process->frames[process->num_frames + i];
+            int page = fm->frames[f].page_number;
+            unmap_frame(fm, f);
+            map_frame(fm, slot * size + i, page);
+        }
+        memmove(&process->frames[process->num_superframes + 1], &process->frames[process->num_superframes],
+            (process->num_frames - process->num_superframes) * sizeof(int));
+        process->frames[process->num_superframes] = slot * size;
+        process->num_superframes++;
+        process->num_frames++;
+        fm->promotions++;
+    }
+}
+
+// Print every frame the process holds, in frame order, as for base frames
+void print_process_frames(FrameManager* fm, Process* process) {
+
+    if (process->num_superframes == 0) {
+        print_mem_frames(process->frames, process->num_frames);
+        return;
+    }
 
+    int frames[TOTAL_FRAMES];
+    int n = 0;
+    for (int i = 0; i < process->num_frames; i++) {
+        int span = i < process->num_superframes ? fm->superframe_frames : 1;
+        for (int f = process->frames[i]; f < process->frames[i] + span; f++) {
+            frames[n++] = f;
+        }
+    }
+    qsort(frames, n, sizeof(int), compare_frame_number);
+    print_mem_frames(frames, n);
+}
+
+void print_superframe_stats(FrameManager* fm) {
+
+    if (fm->superframe_frames != BASE_FRAMES_ONLY) {
+        printf("Superframes %ld\n", fm->superframes_mapped);
+        printf("Superframe promotions %ld\n", fm->promotions);
+        printf("Superframe fallbacks %ld\n", fm->fallbacks);
+        printf("Page-list entries %ld for %ld frames\n", fm->entries_mapped, fm->frames_mapped);
+        printf("Superframe padding %.2f%% peak %dKB\n",
+            fm->frames_mapped ? 100.0 * fm->padding_mapped / fm->frames_mapped : 0.0,
+            fm->peak_padding_frames * FRAME_SIZE);
+    }
+}
+
+static void map_frame(FrameManager* fm, int frame, int page) {
+
+    count_bank_frame(fm, frame, ALLOCATED);
+    fm->frames[frame].page_number = page;
+    fm->frames[frame].is_allocated = ALLOCATED;
+    fm->frames_in_use++;
+    if (fm->superframe_frames != BASE_FRAMES_ONLY) {
+        fm->slot_used[frame / fm->superframe_frames]++;
+    }
+}
+
+static void unmap_frame(FrameManager* fm, int frame) {
+
+    count_bank_frame(fm, frame, NOT_ALLOCATED);
+    release_frame(&fm->frames[frame]);
+    fm->frames_in_use--;
+    // Frames mapped elsewhere, as by virtual memory, were never counted
+    if (fm->superframe_frames != BASE_FRAMES_ONLY) {
+        fm->slot_used[frame / fm->superframe_frames]--;
+    }
+}
+
+static int compare_frame_number(const void* a, const void* b) {
+
+    return *(const int*) a - *(const int*) b;
+}
@@ -6,24 +6,67 @@
 #define TOTAL_FRAMES (MAX_KB_AVAILABLE/FRAME_SIZE)
 #define NOT_IN_USE -1
 #define MIN_PAGE_ALLOCATION 4 // for virtual: minimum number of pages required to be allocated for a process to be able to run.
+#define BASE_FRAMES_ONLY 1 // superframe size when superframes are off
+
+typedef enum {
+    REPLACE_PROCESS, // evict whole-process prefixes chosen by process-level LRU
+    REPLACE_LRU,
+    REPLACE_CLOCK,
+    REPLACE_SECOND_CHANCE,
+    REPLACE_WSCLOCK
+} ReplacementPolicy;
 
 typedef struct Frame {
     int page_number;
     int is_allocated;
     int last_used_time;
+    int owner; // index of the process holding the frame, for page-level replacement
+    int referenced; // reference bit, set each quantum the owner runs
 } Frame;
 
 typedef struct FrameManager {
     Frame frames[TOTAL_FRAMES];
     int frames_in_use;
+    ReplacementPolicy policy; // how victims are chosen in virtual mode
+    int clock_hand; // next frame inspected by clock and wsclock
+    int list_prev[TOTAL_FRAMES]; // resident frames in recency (lru) or load (second-chance) order
+    int list_next[TOTAL_FRAMES];
+    int list_head;
+    int list_tail;
+    int working_set_window; // wsclock: frames idle for longer than this may be evicted
+    int page_evictions;
+    struct AccessModel* access_model; // demand paging: page references generated while processes run
+    struct NumaModel* numa; // memory banks, or NULL for one flat memory
+    struct SwapDevice* swap; // where page-level replacement writes evicted pages, or NULL to drop them
+    struct GroupTable* groups; // memory groups and their quotas, or NULL if the trace has none
+
+    // Paged only: superframes of this many aligned frames, each mapped by one page-list entry
+    int superframe_frames;
+    int slot_used[TOTAL_FRAMES]; // frames in use in each superframe-aligned slot
+    int padding_frames; // frames held only because a process's last superframe was rounded up
+    int peak_padding_frames;
+    long superframes_mapped;
+    long promotions; // runs of base frames moved into a superframe once one was free
+    long fallbacks; // superframes asked for but served as base frames, for want of a free slot
+    long entries_mapped; // page-list entries and frames handed out by allocations
+    long frames_mapped;
+    long padding_mapped;
 } FrameManager;  
 
 void init_frames(FrameManager* fm);
+int frame_in_order(FrameManager* fm, Process* process, int i);
 int allocate_pages(FrameManager* fm, ProcessManager* pm, Process* process_to_allocate);
 int allocate_frames(FrameManager* fm, Process* process, int required_pages);
+int allocate_pages_batch(FrameManager* fm, Process** processes, int n);
 void release_frames(FrameManager* fm, Process* process);
 void release_frame(Frame* frame);
-void print_eviction_notice(ProcessManager* pm, Process* process);
+void print_eviction_notice(ProcessManager* pm, FrameManager* fm, Process* process);
+int parse_superframe_size(const char* arg, int* superframe_frames);
+int frames_held(FrameManager* fm, Process* process);
+int allocate_superframes(FrameManager* fm, Process* process, int required_pages);
+void promote_frames(FrameManager* fm, Process* process);
+void print_process_frames(FrameManager* fm, Process* process);
+void print_superframe_stats(FrameManager* fm);
 
 
 #endif // PAGED_ALLOCATION_H
\ No newline at end of file
@@ -1,6 +1,19 @@
 #include "process.h"
 
-Process* init_processes (char* filename, int* num_processes) {
+#define MAX_HEADER_LINE 256
+
+static void read_trace_header(FILE* fp, char* filename, TraceHeader* header);
+static void read_trace_columns(FILE* fp, char* filename, TraceHeader* header, Process* process);
+static int compare_priority(const void* a, const void* b);
+static void occupy_level(CircularQueue* cq, int level);
+static void vacate_top_level(CircularQueue* cq);
+
+
+// Reads a trace of "{arrival} {name} {service time} {memory}" lines. A version 2 trace starts with
+// a header of '#' lines: "#trace 2 {column}..." names the columns added to each line (priority,
+// nice or group), "#group {name} {KB}" declares a memory group and its quota, and others are
+// comments.
+Process* init_processes (char* filename, int* num_processes, TraceHeader* header) {
 
     FILE* fp = NULL;
     Process* processes = NULL;
@@ -13,6 +26,8 @@ Process* init_processes (char* filename, int* num_processes) {
         exit(EXIT_FAILURE);
     }
 
+    read_trace_header(fp, filename, header);
+
     processes = (Process*) malloc(init_capacity * sizeof(Process));
 
     if (!processes) {
@@ -25,11 +40,21 @@ Process* init_processes (char* filename, int* num_processes) {
     processes[*num_processes].name, &processes[*num_processes].remaining_time, 
     &processes[*num_processes].memory_requirement) == NUM_PROCESS_INPUTS) {
 
+        read_trace_columns(fp, filename, header, &processes[*num_processes]);
+
         // Record service time as the initial remaining time for performance statistics
         processes[*num_processes].service_time = processes[*num_processes].remaining_time;
         processes[*num_processes].memory_allocated = NOT_ALLOCATED;
+        processes[*num_processes].memory_block = NULL;
         processes[*num_processes].frames = NULL;
         processes[*num_processes].num_frames = 0;
+        processes[*num_processes].num_superframes = 0;
+        processes[*num_processes].page_table = NULL;
+        processes[*num_processes].num_pages = 0;
+        processes[*num_processes].home_bank = 0;
+        processes[*num_processes].remote_fraction = 0;
+        processes[*num_processes].last_core = NO_CORE;
+        processes[*num_processes].status = READY;
 
         (*num_processes)++;
 
@@ -62,6 +87,128 @@ Process* init_processes (char* filename, int* num_processes) {
     return processes;
 }
 
+static void read_trace_header(FILE* fp, char* filename, TraceHeader* header) {
+    char line[MAX_HEADER_LINE];
+    int c;
+
+    memset(header, 0, sizeof(TraceHeader));
+    header->version = 1;
+
+    while ((c = fgetc(fp)) == '#') {
+        if (!fgets(line, sizeof(line), fp)) {
+            break;
+        }
+        char* word = strtok(line, " \t\r\n");
+        if (word && strcmp(word, "trace") == 0) {
+            char* version = strtok(NULL, " \t\r\n");
+            header->version = version ? atoi(version) : 0;
+            if (header->version < 1 || header->version > TRACE_VERSION) {
+                fprintf(stderr, "Error: Unsupported trace version %s in %s\n", version ? version : "", filename);
+                exit(EXIT_FAILURE);
+            }
+            while ((word = strtok(NULL, " \t\r\n"))) {
+                TraceColumn column;
+                if (strcmp(word, "priority") == 0) {
+                    column = COLUMN_PRIORITY;
+                } else if (strcmp(word, "nice") == 0) {
+                    column = COLUMN_NICE;
+                } else if (strcmp(word, "group") == 0) {
+                    column = COLUMN_GROUP;
+                } else {
+                    fprintf(stderr, "Error: Unknown trace column %s in %s\n", word, filename);
+                    exit(EXIT_FAILURE);
+                }
+                if (header->version < 2) {
+                    fprintf(stderr, "Error: Invalid columns for a version %d trace in %s\n", header->version, filename);
+                    exit(EXIT_FAILURE);
+                }
+                for (int i = 0; i < header->num_columns; i++) {
+                    if (header->columns[i] == column) {
+                        fprintf(stderr, "Error: Trace column %s given twice in %s\n", word, filename);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                // Both set the process's priority, one the other way round from the other
+                if (column != COLUMN_GROUP && header->prioritised) {
+                    fprintf(stderr, "Error: A trace cannot have both priority and nice columns in %s\n", filename);
+                    exit(EXIT_FAILURE);
+                }
+                header->prioritised |= column != COLUMN_GROUP;
+                header->columns[header->num_columns++] = column;
+            }
+        } else if (word && strcmp(word, "group") == 0 && header->version >= 2) {
+            // Groups came with version 2; in an older file this line is a comment
+            char* name = strtok(NULL, " \t\r\n");
+            char* limit = strtok(NULL, " \t\r\n");
+            GroupTable* groups = &header->groups;
+            if (!name || !limit || strlen(name) >= MAX_PROCESS_NAME || atoi(limit) <= 0) {
+                fprintf(stderr, "Error: Invalid group declaration in %s\n", filename);
+                exit(EXIT_FAILURE);
+            }
+            if (groups->num_groups == MAX_GROUPS) {
+                fprintf(stderr, "Error: More than %d groups in %s\n", MAX_GROUPS, filename);
+                exit(EXIT_FAILURE);
+            }
+            strcpy(groups->groups[groups->num_groups].name, name);
+            groups->groups[groups->num_groups++].limit = atoi(limit);
+        }
+    }
+    if (c != EOF) {
+        ungetc(c, fp);
+    }
+}
+
+// Reads the columns the header added to a process line, which must all be on that line
+static void read_trace_columns(FILE* fp, char* filename, TraceHeader* header, Process* process) {
+    char line[MAX_HEADER_LINE];
+
+    process->priority = DEFAULT_PRIORITY;
+    process->group = NO_GROUP;
+    if (header->num_columns == 0) {
+        return;
+    }
+    if (!fgets(line, sizeof(line), fp)) {
+        line[0] = '\0';
+    }
+
+    char* word = strtok(line, " \t\r\n");
+    for (int i = 0; i < header->num_columns; i++, word = strtok(NULL, " \t\r\n")) {
+        if (!word) {
+            fprintf(stderr, "Error: Process %s has too few columns in %s\n", process->name, filename);
+            exit(EXIT_FAILURE);
+        }
+        switch (header->columns[i]) {
+            case COLUMN_PRIORITY:
+            case COLUMN_NICE:
+                process->priority = atoi(word);
+                if (header->columns[i] == COLUMN_NICE) {
+                    process->priority = -process->priority;
+                }
+                break;
+
+            case COLUMN_GROUP:
+                // "-" puts the process in no group
+                if (strcmp(word, "-") == 0) {
+                    break;
+                }
+                for (int g = 0; g < header->groups.num_groups; g++) {
+                    if (strcmp(header->groups.groups[g].name, word) == 0) {
+                        process->group = g;
+                    }
+                }
+                if (process->group == NO_GROUP) {
+                    fprintf(stderr, "Error: Process %s is in undeclared group %s in %s\n", process->name, word, filename);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+        }
+    }
+    if (word) {
+        fprintf(stderr, "Error: Process %s has too many columns in %s\n", process->name, filename);
+        exit(EXIT_FAILURE);
+    }
+}
+
 void init_process_manager(ProcessManager* pm, int num_processes, int quantum) {
 
     pm->simulation_time = 0;
@@ -69,6 +216,22 @@ void init_process_manager(ProcessManager* pm, int num_processes, int quantum) {
     pm->next_process_index = 0;
     pm->num_processes = num_processes;
     pm->quantum = quantum;
+    pm->interrupted_process_index = NOT_INTERRUPTED;
+    pm->checkpoint_path = NULL;
+    pm->next_checkpoint_time = __INT_MAX__;
+    pm->checkpoint_interval = 0;
+    pm->cores = NULL;
+    pm->monitor = NULL;
+    pm->stop_time = NO_STOP;
+    pm->stats.total_turnaround = 0;
+    pm->stats.total_overhead = 0;
+    pm->stats.max_overhead = 0;
+    pm->stats.next_summed = 0;
+    pm->stats.pending_overhead = NULL;
+    pm->stats.pending_capacity = 0;
+    pm->stats.num_killed = 0;
+    pm->stats.turnaround_sketch = NULL;
+    pm->stats.overhead_sketch = NULL;
     init_scheduler_queue(&pm->current_processes, pm->num_processes);
     pm->last_used_times = (int*) malloc(num_processes * sizeof(int));
     for (int i = 0; i < num_processes; i++) {
@@ -79,7 +242,7 @@ void init_process_manager(ProcessManager* pm, int num_processes, int quantum) {
 //  Circular queue implementation was adapted from https://www.programiz.com/dsa/circular-queue
 void init_scheduler_queue(CircularQueue* queue, int capacity) {
     queue->arr = (int*)malloc(capacity * sizeof(int));
-    if (!queue->arr) {
+    if (!queue->arr && capacity > 0) {
         perror("Failed to allocate memory for scheduler queue");
         exit(EXIT_FAILURE);
     }
@@ -87,6 +250,66 @@ void init_scheduler_queue(CircularQueue* queue, int capacity) {
     queue->head = -1; 
     queue->tail = -1; 
     queue->size = 0;
+    queue->by_priority = NULL;
+    queue->levels = NULL;
+    queue->num_levels = 0;
+    queue->level = NULL;
+    queue->occupied = NULL;
+    queue->num_occupied = 0;
+}
+
+// From here on keep the queue in priority order. Each priority in the process table gets a FIFO
+// big enough for all of its processes, and anything already queued moves into them in order.
+void prioritise_queue(CircularQueue* cq, Process* processes, int num_processes) {
+    int* priorities = (int*) malloc(num_processes * sizeof(int));
+    cq->level = (int*) malloc(num_processes * sizeof(int));
+    if ((!priorities || !cq->level) && num_processes > 0) {
+        perror("Failed to allocate memory for scheduler queue");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < num_processes; i++) {
+        priorities[i] = processes[i].priority;
+    }
+    qsort(priorities, num_processes, sizeof(int), compare_priority);
+    cq->num_levels = 0;
+    for (int i = 0; i < num_processes; i++) {
+        if (i == 0 || priorities[i] != priorities[cq->num_levels - 1]) {
+            priorities[cq->num_levels++] = priorities[i];
+        }
+    }
+
+    int* counts = (int*) calloc(cq->num_levels, sizeof(int));
+    cq->levels = (CircularQueue*) malloc(cq->num_levels * sizeof(CircularQueue));
+    cq->occupied = (int*) malloc(cq->num_levels * sizeof(int));
+    if ((!counts || !cq->levels || !cq->occupied) && cq->num_levels > 0) {
+        perror("Failed to allocate memory for scheduler queue");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < num_processes; i++) {
+        int* found = bsearch(&processes[i].priority, priorities, cq->num_levels, sizeof(int), compare_priority);
+        cq->level[i] = found - priorities;
+        counts[cq->level[i]]++;
+    }
+    for (int l = 0; l < cq->num_levels; l++) {
+        init_scheduler_queue(&cq->levels[l], counts[l]);
+    }
+    free(counts);
+    free(priorities);
+
+    int queued = cq->size;
+    int* order = (int*) malloc(queued * sizeof(int));
+    if (!order && queued > 0) {
+        perror("Failed to allocate memory for scheduler queue");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < queued; i++) {
+        order[i] = dequeue(cq);
+    }
+    cq->by_priority = processes;
+    for (int i = 0; i < queued; i++) {
+        enqueue(cq, order[i]);
+    }
+    free(order);
 }
 
 void enqueue(CircularQueue* cq, int process_index) {
@@ -94,6 +317,18 @@ void enqueue(CircularQueue* cq, int process_index) {
         perror("Error: Attempting to enqueue to a full queue\n");
         exit(EXIT_FAILURE);
     }
+
+    // With priorities, it joins the back of its own level
+    if (cq->by_priority) {
+        int level = cq->level[process_index];
+        if (cq->levels[level].size == 0) {
+            occupy_level(cq, level);
+        }
+        enqueue(&cq->levels[level], process_index);
+        cq->size++;
+        return;
+    }
+
     if (cq->head == -1) {
         cq->head = 0;
     }
@@ -109,6 +344,18 @@ int dequeue(CircularQueue* cq) {
         perror("Queue is empty. Cannot dequeue.\n");
         return -1; 
     }
+
+    // With priorities, the head of the top level
+    if (cq->by_priority) {
+        int level = cq->occupied[0];
+        int process_index = dequeue(&cq->levels[level]);
+        cq->size--;
+        if (cq->levels[level].size == 0) {
+            vacate_top_level(cq);
+        }
+        return process_index;
+    }
+
     // Get the process index stored at the head of the circular queue
     
     int process_index = cq->arr[cq->head];
@@ -124,6 +371,74 @@ int dequeue(CircularQueue* cq) {
     return process_index;
 }
 
+// The process i places behind the head of the queue. With priorities the levels are walked from
+// the top, so this is quickest for the processes of the top priority.
+int queue_at(CircularQueue* cq, int i) {
+
+    if (cq->by_priority) {
+        int level = cq->occupied[0];
+        while (i >= cq->levels[level].size) {
+            i -= cq->levels[level++].size;
+        }
+        return queue_at(&cq->levels[level], i);
+    }
+    return cq->arr[(cq->head + i) % cq->capacity];
+}
+
+void free_scheduler_queue(CircularQueue* cq) {
+
+    for (int l = 0; l < cq->num_levels; l++) {
+        free_scheduler_queue(&cq->levels[l]);
+    }
+    free(cq->levels);
+    free(cq->level);
+    free(cq->occupied);
+    free(cq->arr);
+    cq->arr = NULL;
+}
+
+// Highest priority first
+static int compare_priority(const void* a, const void* b) {
+    int pa = *(const int*) a;
+    int pb = *(const int*) b;
+
+    return pa > pb ? -1 : pa < pb;
+}
+
+// Levels are numbered from the highest priority, so the heap keeps the lowest number on top
+static void occupy_level(CircularQueue* cq, int level) {
+    int slot = cq->num_occupied++;
+
+    while (slot > 0 && cq->occupied[(slot - 1) / 2] > level) {
+        cq->occupied[slot] = cq->occupied[(slot - 1) / 2];
+        slot = (slot - 1) / 2;
+    }
+    cq->occupied[slot] = level;
+}
+
+static void vacate_top_level(CircularQueue* cq) {
+    int level = cq->occupied[--cq->num_occupied];
+    int slot = 0;
+
+    while (1) {
+        int child = 2 * slot + 1;
+        if (child >= cq->num_occupied) {
+            break;
+        }
+        if (child + 1 < cq->num_occupied && cq->occupied[child + 1] < cq->occupied[child]) {
+            child++;
+        }
+        if (cq->occupied[child] >= level) {
+            break;
+        }
+        cq->occupied[slot] = cq->occupied[child];
+        slot = child;
+    }
+    if (cq->num_occupied > 0) {
+        cq->occupied[slot] = level;
+    }
+}
+
 int is_scheduler_empty(CircularQueue* cq) {
     return cq->size == 0;
 }
@@ -178,10 +493,11 @@ int compare_process(Process* p1, Process* p2) {
     return NOT_SAME;
 }
 
-/* Retrieve Least Recently Used (LRU) process based on smallest simulation time of last run. */
+/* Retrieve Least Recently Used (LRU) process based on smallest simulation time of last run.
+   Processes running on other cores are never chosen; NULL if no process can be evicted. */
 Process* find_lru_process(ProcessManager* pm, Process* cur) {
     int min_time = __INT_MAX__;
-    int lru_index = 0;
+    int lru_index = NOT_INTERRUPTED;
 
     for (int i = 0; i < pm->num_processes; i++) {
         // Find out the last time the process ran
@@ -195,6 +511,9 @@ Process* find_lru_process(ProcessManager* pm, Process* cur) {
         if (compare_process(lru_process, cur) == SAME) {
             continue;
         } 
+        if (lru_process->status == RUNNING) {
+            continue;
+        }
         int last_used_time = pm->last_used_times[i];
         if (last_used_time < min_time) {
             min_time = last_used_time;
@@ -202,6 +521,9 @@ Process* find_lru_process(ProcessManager* pm, Process* cur) {
         }
             
     }
+    if (lru_index == NOT_INTERRUPTED) {
+        return NULL;
+    }
     Process* lru_process = &pm->processes[lru_index];
     return lru_process;
 }
@@ -217,9 +539,9 @@ void free_process_manager(ProcessManager pm) {
         free(pm.last_used_times);
         pm.last_used_times = NULL;
     }
-    if (pm.current_processes.arr != NULL) {
-        free(pm.current_processes.arr);
-        pm.current_processes.arr = NULL;
-    }
+    free_scheduler_queue(&pm.current_processes);
+    free(pm.stats.turnaround_sketch);
+    free(pm.stats.overhead_sketch);
+    free(pm.stats.pending_overhead);
 
 }
\ No newline at end of file
@@ -9,6 +9,14 @@
 #define ALLOCATED 1
 #define NOT_ALLOCATED 0
 #define NOT_INTERRUPTED -1
+#define NO_CORE -1
+#define NO_STOP -1
+#define NOT_FINISHED -1
+#define TRACE_VERSION 2 // the newest trace format; files without a header are version 1
+#define MAX_TRACE_COLUMNS 3
+#define MAX_GROUPS 32
+#define NO_GROUP -1
+#define DEFAULT_PRIORITY 0
 
 typedef enum {
     READY,
@@ -28,17 +36,81 @@ typedef struct {
     MemoryAddress *memory_block; // Pointer to the memory block allocated to the process
     int* frames; // Array of frames indices allocated to the process
     int num_frames; // Number of frames allocated to the process
+    int num_superframes; // The first entries of frames each map a whole superframe from that frame on
+    int* page_table; // Frame holding each page, or NOT_IN_USE (page-level replacement only)
+    int num_pages; // Number of pages the process needs in total
+    int home_bank; // Memory bank local to the process, when memory is split into banks
+    double remote_fraction; // Fraction of its memory placed outside the home bank
+    int last_core; // Core the process last ran on, or NO_CORE
+    int priority; // Higher runs first, when the trace gives priorities
+    int group; // Index of the process's memory group, or NO_GROUP
     Status status;
 } Process;
 
-typedef struct {
+typedef struct CircularQueue {
     int* arr;
     int size;
     int capacity;
     int head;
     int tail;
+    Process* by_priority; // if set, these processes are kept in priority order in levels, else in arr
+                          // in arrival order
+
+    // With priorities: a FIFO for each priority in the process table, highest first, so processes
+    // of equal priority take turns
+    struct CircularQueue* levels;
+    int num_levels;
+    int* level; // the level of each process
+    int* occupied; // min-heap of the levels with processes queued, so the top one is first
+    int num_occupied;
 } CircularQueue;
 
+// Columns a version 2 trace may add after the four of version 1
+typedef enum {
+    COLUMN_PRIORITY,
+    COLUMN_NICE, // a priority given the Unix way round: lower runs first
+    COLUMN_GROUP
+} TraceColumn;
+
+// A memory group declared in the trace header. Like a cgroup, its processes share a quota on
+// the memory they hold at once.
+typedef struct {
+    char name[MAX_PROCESS_NAME];
+    int limit; // in KB
+    int used;
+    int peak;
+    long refused; // allocations refused because the group was at its quota
+    long reclaimed; // processes of the group evicted to keep it within its quota
+} MemoryGroup;
+
+typedef struct GroupTable {
+    int num_groups;
+    MemoryGroup groups[MAX_GROUPS];
+} GroupTable;
+
+// What the header of a trace declares
+typedef struct {
+    int version;
+    TraceColumn columns[MAX_TRACE_COLUMNS];
+    int num_columns;
+    int prioritised; // a priority or nice column was given
+    GroupTable groups;
+} TraceHeader;
+
+
+// Statistics of the finished processes, accumulated as each one finishes
+typedef struct {
+    long total_turnaround;
+    double total_overhead; // summed in arrival order, so it rounds exactly as a pass over the table would
+    double max_overhead;
+    int next_summed; // the processes before this index have all finished and are in total_overhead
+    double* pending_overhead; // overheads of the later processes that have finished, by arrival index
+                              // modulo pending_capacity; NOT_FINISHED for a process that has not
+    int pending_capacity;
+    int num_killed; // killed for want of swap space; these did not complete and are left out
+    struct Sketch* turnaround_sketch; // for percentiles, or NULL
+    struct Sketch* overhead_sketch;
+} RunStats;
 
 typedef struct {
     Process* processes;
@@ -50,14 +122,24 @@ typedef struct {
     int completed_processes;
     int next_process_index;
     int interrupted_process_index;
+    char* checkpoint_path; // Where snapshots of the simulation are written, if anywhere
+    int next_checkpoint_time;
+    int checkpoint_interval;
+    struct CoreSet* cores; // per-core run queues, or NULL for the single-core scheduler
+    struct Monitor* monitor; // where progress is published for --monitor, or NULL
+    int stop_time; // --verify replays stop at the first step after this time, or NO_STOP
+    RunStats stats;
 } ProcessManager;
 
 
-Process* init_processes (char* filename, int* num_processes);
+Process* init_processes (char* filename, int* num_processes, TraceHeader* header);
 void init_process_manager(ProcessManager* pm, int num_processes, int quantum);
 void init_scheduler_queue(CircularQueue* queue, int capacity);
+void prioritise_queue(CircularQueue* cq, Process* processes, int num_processes);
 void enqueue(CircularQueue* cq, int process_index);
 int dequeue(CircularQueue* cq);
+int queue_at(CircularQueue* cq, int i);
+void free_scheduler_queue(CircularQueue* cq);
 int is_scheduler_empty(CircularQueue* cq);
 void free_pages(Process* process);
 const char* get_status_string(Status status);
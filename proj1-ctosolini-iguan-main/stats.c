@@ -0,0 +1,169 @@
+#include "stats.h"
+
+static void sum_in_order(RunStats* stats, int index, double overhead);
+static void grow_pending(RunStats* stats, int needed);
+static Sketch* create_sketch(void);
+static void sketch_add(Sketch* sketch, double value);
+static double sketch_percentile(Sketch* sketch, double p);
+
+static double turnaround_time(Process* process) {
+
+    return process->completion_time - process->time_arrived;
+}
+
+static double overhead_time(Process* process) {
+
+    return turnaround_time(process) / process->service_time;
+}
+
+// Keep percentile sketches of turnaround and overhead as well as the totals
+void enable_percentiles(RunStats* stats) {
+
+    stats->turnaround_sketch = create_sketch();
+    stats->overhead_sketch = create_sketch();
+}
+
+// Account for a process that has just finished. Turnaround is an integer sum and the maximum does
+// not depend on order, but the overhead total is a floating-point sum: it only takes in a process
+// once every earlier arrival has finished, so it is added in the same order whatever the order of
+// completion. Until then its overhead waits in pending_overhead, so nothing has to be read back
+// from the process table.
+void record_completion(ProcessManager* pm, Process* process) {
+    RunStats* stats = &pm->stats;
+    int index = process - pm->processes;
+    double overhead = overhead_time(process);
+
+    stats->total_turnaround += (long) turnaround_time(process);
+    if (overhead > stats->max_overhead) {
+        stats->max_overhead = overhead;
+    }
+    if (stats->turnaround_sketch) {
+        sketch_add(stats->turnaround_sketch, turnaround_time(process));
+        sketch_add(stats->overhead_sketch, overhead);
+    }
+    sum_in_order(stats, index, overhead);
+}
+
+// A process killed for want of swap space did not complete, so it is left out of the statistics.
+// It still takes its turn in the overhead order, adding nothing, so the processes behind it are
+// summed.
+void record_kill(ProcessManager* pm, Process* process) {
+    RunStats* stats = &pm->stats;
+
+    stats->num_killed++;
+    sum_in_order(stats, process - pm->processes, 0);
+}
+
+static void sum_in_order(RunStats* stats, int index, double overhead) {
+
+    if (index - stats->next_summed >= stats->pending_capacity) {
+        grow_pending(stats, index - stats->next_summed + 1);
+    }
+    stats->pending_overhead[index % stats->pending_capacity] = overhead;
+    while (stats->pending_overhead[stats->next_summed % stats->pending_capacity] != NOT_FINISHED) {
+        stats->total_overhead += stats->pending_overhead[stats->next_summed % stats->pending_capacity];
+        stats->pending_overhead[stats->next_summed % stats->pending_capacity] = NOT_FINISHED;
+        stats->next_summed++;
+    }
+}
+
+// The window only has to span the processes that finished ahead of the earliest unfinished one
+static void grow_pending(RunStats* stats, int needed) {
+    int capacity = stats->pending_capacity > 0 ? stats->pending_capacity : INIT_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    double* pending = (double*) malloc(capacity * sizeof(double));
+    if (!pending) {
+        perror("Error: Could not allocate memory for the pending overheads.");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < capacity; i++) {
+        pending[i] = NOT_FINISHED;
+    }
+    for (int i = stats->next_summed; i < stats->next_summed + stats->pending_capacity; i++) {
+        pending[i % capacity] = stats->pending_overhead[i % stats->pending_capacity];
+    }
+    free(stats->pending_overhead);
+    stats->pending_overhead = pending;
+    stats->pending_capacity = capacity;
+}
+
+void print_performance_stats(ProcessManager* pm) {
+    RunStats* stats = &pm->stats;
+
+    // Calculate the average turnaround and overhead time over the processes that completed
+    int num_completed = pm->num_processes - stats->num_killed;
+    int average_turnaround_time = 0;
+    double average_overhead_time = 0;
+    if (num_completed > 0) {
+        average_turnaround_time = (int)ceil((double)stats->total_turnaround / num_completed);
+        average_overhead_time = round(stats->total_overhead / num_completed * 100) / 100.0;
+    }
+
+    printf("Turnaround time %d\n", average_turnaround_time);
+    printf("Time overhead %.2f %.2f\n", stats->max_overhead, average_overhead_time);
+    printf("Makespan %d\n", pm->simulation_time);
+
+    if (stats->turnaround_sketch) {
+        printf("Turnaround percentiles %d %d %d\n", (int) round(sketch_percentile(stats->turnaround_sketch, 0.50)),
+            (int) round(sketch_percentile(stats->turnaround_sketch, 0.95)),
+            (int) round(sketch_percentile(stats->turnaround_sketch, 0.99)));
+        printf("Time overhead percentiles %.2f %.2f %.2f\n", sketch_percentile(stats->overhead_sketch, 0.50),
+            sketch_percentile(stats->overhead_sketch, 0.95), sketch_percentile(stats->overhead_sketch, 0.99));
+    }
+}
+
+static Sketch* create_sketch(void) {
+
+    Sketch* sketch = (Sketch*) calloc(1, sizeof(Sketch));
+    if (!sketch) {
+        perror("Error: Could not allocate memory for a percentile sketch.");
+        exit(EXIT_FAILURE);
+    }
+    return sketch;
+}
+
+static double sketch_gamma(void) {
+
+    return (1 + SKETCH_ACCURACY) / (1 - SKETCH_ACCURACY);
+}
+
+static void sketch_add(Sketch* sketch, double value) {
+
+    int bucket = 0;
+    if (value > 1) {
+        bucket = (int) ceil(log(value) / log(sketch_gamma()));
+        if (bucket >= SKETCH_BUCKETS) {
+            bucket = SKETCH_BUCKETS - 1;
+        }
+    }
+    sketch->counts[bucket]++;
+    sketch->count++;
+}
+
+// The value of nearest rank p * count, within SKETCH_ACCURACY of the true one, or 0 if the
+// sketch is empty
+static double sketch_percentile(Sketch* sketch, double p) {
+
+    if (sketch->count == 0) {
+        return 0;
+    }
+    long rank = (long) ceil(p * sketch->count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    long seen = 0;
+    int bucket = 0;
+    while (bucket < SKETCH_BUCKETS - 1 && seen + sketch->counts[bucket] < rank) {
+        seen += sketch->counts[bucket];
+        bucket++;
+    }
+    if (bucket == 0) {
+        return 1;
+    }
+    // The point of the bucket with the same relative distance to both of its bounds
+    double gamma = sketch_gamma();
+    return 2 * pow(gamma, bucket) / (gamma + 1);
+}
@@ -0,0 +1,21 @@
+#ifndef STATS_H
+#define STATS_H
+#include "process.h"
+
+#define SKETCH_ACCURACY 0.01 // relative error of a reported percentile
+#define SKETCH_BUCKETS 2048 // covers values up to about 10^17
+
+// Log-bucketed histogram: bucket i > 0 counts the values in (gamma^(i-1), gamma^i], and bucket 0
+// those up to 1. Its size does not grow with the number of values, and sketches of two parts of
+// a run combine by adding their counts.
+typedef struct Sketch {
+    long counts[SKETCH_BUCKETS];
+    long count;
+} Sketch;
+
+void enable_percentiles(RunStats* stats);
+void record_completion(ProcessManager* pm, Process* process);
+void record_kill(ProcessManager* pm, Process* process);
+void print_performance_stats(ProcessManager* pm);
+
+#endif // STATS_H
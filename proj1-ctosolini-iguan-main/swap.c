@@ -0,0 +1,133 @@
+#include "swap.h"
+#include "page_replacement.h"
+#include "multicore.h"
+#include "stats.h"
+
+
+int parse_swap_full_policy(const char* name, SwapFullPolicy* policy) {
+
+    if (strcmp(name, "discard") == 0) {
+        *policy = SWAP_FULL_DISCARD;
+    } else if (strcmp(name, "kill") == 0) {
+        *policy = SWAP_FULL_KILL;
+    } else {
+        return NOT_ALLOCATED;
+    }
+    return ALLOCATED;
+}
+
+void init_swap(SwapDevice* swap, int capacity_kb, double bandwidth, SwapFullPolicy full_policy, ProcessManager* pm) {
+
+    memset(swap, 0, sizeof(SwapDevice));
+    swap->capacity = capacity_kb / FRAME_SIZE;
+    swap->bandwidth = bandwidth;
+    swap->full_policy = full_policy;
+    swap->processes = pm->processes;
+    swap->num_processes = pm->num_processes;
+    swap->on_swap = calloc(pm->num_processes, sizeof(unsigned char*));
+    swap->swapped = calloc(pm->num_processes, sizeof(int));
+    if ((!swap->on_swap || !swap->swapped) && pm->num_processes > 0) {
+        perror("Error: Failed to allocate memory for the swap device");
+        exit(EXIT_FAILURE);
+    }
+}
+
+int swap_full(SwapDevice* swap) {
+
+    return swap->used >= swap->capacity;
+}
+
+// Write an evicted page out, or drop it if there is no room
+void swap_out(SwapDevice* swap, int process_index, int page) {
+
+    if (swap_full(swap)) {
+        swap->discarded++;
+        return;
+    }
+    if (!swap->on_swap[process_index]) {
+        Process* process = &swap->processes[process_index];
+        swap->on_swap[process_index] = calloc(process->num_pages, sizeof(unsigned char));
+        if (!swap->on_swap[process_index]) {
+            perror("Error: Failed to allocate memory for the swap device");
+            exit(EXIT_FAILURE);
+        }
+    }
+    swap->on_swap[process_index][page] = 1;
+    swap->swapped[process_index]++;
+    if (++swap->used > swap->peak) {
+        swap->peak = swap->used;
+    }
+    swap->pages_out++;
+    swap->pending++;
+}
+
+// Read a page back if it was swapped out; a page never evicted, or dropped, loads for free
+void swap_in(SwapDevice* swap, int process_index, int page) {
+
+    if (!swap->on_swap[process_index] || !swap->on_swap[process_index][page]) {
+        return;
+    }
+    swap->on_swap[process_index][page] = 0;
+    swap->swapped[process_index]--;
+    swap->used--;
+    swap->pages_in++;
+    swap->pending++;
+}
+
+// A process that finishes or is killed gives up its swap space
+void release_swap(SwapDevice* swap, Process* process) {
+    int index = process - swap->processes;
+
+    swap->used -= swap->swapped[index];
+    swap->swapped[index] = 0;
+    free(swap->on_swap[index]);
+    swap->on_swap[index] = NULL;
+}
+
+// Simulated time for the pages moved since the last charge, in whole units
+int charge_swap(SwapDevice* swap) {
+
+    swap->debt += swap->pending * FRAME_SIZE / swap->bandwidth;
+    swap->pending = 0;
+    int charge = (int) swap->debt;
+    swap->debt -= charge;
+    swap->time_charged += charge;
+    return charge;
+}
+
+// Out of memory and swap: the process is terminated where it stands and counts as finished
+void kill_process(FrameManager* fm, ProcessManager* pm, Process* process) {
+
+    release_pages(fm, process);
+    free(process->frames);
+    process->frames = NULL;
+    process->memory_allocated = NOT_ALLOCATED;
+    process->status = FINISHED;
+    process->completion_time = pm->simulation_time;
+    pm->completed_processes++;
+    record_kill(pm, process);
+    fm->swap->kills++;
+
+    printf("%d,KILLED,process-name=%s,proc-remaining=%d\n", pm->simulation_time, process->name, count_ready(pm));
+}
+
+void print_swap_stats(SwapDevice* swap) {
+
+    printf("Swap peak %dKB of %dKB\n", swap->peak * FRAME_SIZE, swap->capacity * FRAME_SIZE);
+    printf("Swap pages out %ld in %ld\n", swap->pages_out, swap->pages_in);
+    printf("Swap time %ld\n", swap->time_charged);
+    // Under kill, pages are still discarded by faults while a process runs
+    printf("Swap discarded pages %ld\n", swap->discarded);
+    if (swap->full_policy == SWAP_FULL_KILL) {
+        printf("Swap kills %ld\n", swap->kills);
+    }
+}
+
+void free_swap(SwapDevice* swap) {
+
+    for (int i = 0; i < swap->num_processes; i++) {
+        free(swap->on_swap[i]);
+    }
+    free(swap->on_swap);
+    free(swap->swapped);
+}
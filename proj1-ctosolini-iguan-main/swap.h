@@ -0,0 +1,44 @@
+#ifndef SWAP_H
+#define SWAP_H
+#include "paged_allocation.h"
+
+#define DEFAULT_SWAP_BANDWIDTH 64.0 // KB moved to or from swap per unit of simulated time
+
+typedef enum {
+    SWAP_FULL_DISCARD, // an evicted page that does not fit is dropped, and comes back empty
+    SWAP_FULL_KILL // a process that needs an eviction swap cannot take is killed
+} SwapFullPolicy;
+
+// A swap device for page-level replacement in virtual mode. Evicted pages are written to it and
+// read back when they are next loaded; every page moved costs simulated time.
+typedef struct SwapDevice {
+    int capacity; // in pages
+    double bandwidth;
+    SwapFullPolicy full_policy;
+    Process* processes; // the process table, to turn processes into indices
+    int num_processes;
+    unsigned char** on_swap; // per process, which of its pages are on swap; NULL until one is
+    int* swapped; // pages of each process on swap
+    int used;
+    int peak;
+    long pages_out;
+    long pages_in;
+    long discarded;
+    long kills;
+    int pending; // pages moved but not yet charged for
+    double debt; // fraction of a time unit charged but not yet added to the simulation
+    long time_charged;
+} SwapDevice;
+
+int parse_swap_full_policy(const char* name, SwapFullPolicy* policy);
+void init_swap(SwapDevice* swap, int capacity_kb, double bandwidth, SwapFullPolicy full_policy, ProcessManager* pm);
+int swap_full(SwapDevice* swap);
+void swap_out(SwapDevice* swap, int process_index, int page);
+void swap_in(SwapDevice* swap, int process_index, int page);
+void release_swap(SwapDevice* swap, Process* process);
+int charge_swap(SwapDevice* swap);
+void kill_process(FrameManager* fm, ProcessManager* pm, Process* process);
+void print_swap_stats(SwapDevice* swap);
+void free_swap(SwapDevice* swap);
+
+#endif // SWAP_H
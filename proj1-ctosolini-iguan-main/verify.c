@@ -0,0 +1,232 @@
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "verify.h"
+#include "multicore.h"
+
+// Each engine runs in a child process with its output on a pipe, so all start from the same
+// state and none can disturb another. The events of each engine are compared with the reference
+// engine's as they arrive. At the first difference every engine is run again from the start,
+// which is deterministic, until the first step after the time of the divergent event, where they
+// report their state instead of printing.
+
+static const char* engine_names[NUM_ENGINES] = {"reference", "single-core", "per-core"};
+
+// Where a replayed engine reports its state
+static FILE* state_out = NULL;
+
+static int spawn_engines(FILE* logs[], pid_t pids[], int replay);
+static int event_time(const char* line);
+static void print_process_state(FILE* out, MemoryManager* mm, FrameManager* fm, Process* process);
+
+
+// Compare the event logs of the engines. Only the engine processes return, each with the engine
+// to run; the verifying process exits with success if the logs match.
+Engine verify_engines(ProcessManager* pm) {
+    FILE* logs[NUM_ENGINES];
+    pid_t pids[NUM_ENGINES];
+    int status[NUM_ENGINES];
+    char lines[NUM_ENGINES][MAX_EVENT_LINE];
+    char last[MAX_EVENT_LINE] = "";
+    long events = 0;
+    int diverged = 0;
+
+    int engine = spawn_engines(logs, pids, 0);
+    if (engine < NUM_ENGINES) {
+        return engine;
+    }
+
+    while (!diverged) {
+        int ended = 0;
+        for (int e = 0; e < NUM_ENGINES; e++) {
+            if (!fgets(lines[e], MAX_EVENT_LINE, logs[e])) {
+                strcpy(lines[e], "(end of output)\n");
+                ended++;
+            }
+        }
+        if (ended == NUM_ENGINES) {
+            break;
+        }
+        for (int e = 0; e < NUM_ENGINES; e++) {
+            if (ended || strcmp(lines[ENGINE_REFERENCE], lines[e]) != 0) {
+                diverged = 1;
+            }
+        }
+        if (!diverged) {
+            strcpy(last, lines[ENGINE_REFERENCE]);
+            events++;
+        }
+    }
+
+    // Nothing past the first difference is needed
+    for (int e = 0; e < NUM_ENGINES; e++) {
+        if (diverged) {
+            kill(pids[e], SIGKILL);
+        }
+        fclose(logs[e]);
+        waitpid(pids[e], &status[e], 0);
+    }
+
+    if (!diverged) {
+        for (int e = 0; e < NUM_ENGINES; e++) {
+            if (!WIFEXITED(status[e]) || WEXITSTATUS(status[e]) != 0) {
+                printf("The engines agree on %ld events, but the %s engine did not exit normally\n",
+                    events, engine_names[e]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        printf("Verified %ld events: the engines agree\n", events);
+        exit(EXIT_SUCCESS);
+    }
+
+    printf("The engines diverge at event %ld\n", events + 1);
+    printf("  last common event: %s", events > 0 ? last : "(none)\n");
+    for (int e = 0; e < NUM_ENGINES; e++) {
+        printf("  %s engine: %s", engine_names[e], lines[e]);
+    }
+
+    // Replay the engines past the earliest of the divergent events. A difference in the final
+    // statistics has no time, so the engines then run to the end.
+    int stop_time = __INT_MAX__;
+    for (int e = 0; e < NUM_ENGINES; e++) {
+        int time = event_time(lines[e]);
+        if (time != NO_STOP && time < stop_time) {
+            stop_time = time;
+        }
+    }
+    pm->stop_time = stop_time;
+    engine = spawn_engines(logs, pids, 1);
+    if (engine < NUM_ENGINES) {
+        return engine;
+    }
+
+    for (int e = 0; e < NUM_ENGINES; e++) {
+        printf("State of the %s engine:\n", engine_names[e]);
+        while (fgets(lines[e], MAX_EVENT_LINE, logs[e])) {
+            printf("  %s", lines[e]);
+        }
+        fclose(logs[e]);
+        waitpid(pids[e], &status[e], 0);
+    }
+    exit(EXIT_FAILURE);
+}
+
+// Fork a process per engine, with its events (or, when replaying, its state) on a pipe. In the
+// engine processes this returns the engine to run; in the calling process it returns NUM_ENGINES
+// with the read ends of the pipes in logs.
+static int spawn_engines(FILE* logs[], pid_t pids[], int replay) {
+
+    for (int e = 0; e < NUM_ENGINES; e++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("Error: Could not create a pipe for --verify");
+            exit(EXIT_FAILURE);
+        }
+        // Anything buffered would otherwise be written again by the child
+        fflush(stdout);
+        pids[e] = fork();
+        if (pids[e] < 0) {
+            perror("Error: Could not start an engine for --verify");
+            exit(EXIT_FAILURE);
+        }
+        if (pids[e] == 0) {
+            close(fds[0]);
+            for (int other = 0; other < e; other++) {
+                fclose(logs[other]);
+            }
+            if (replay) {
+                state_out = fdopen(fds[1], "w");
+                if (!state_out || !freopen("/dev/null", "w", stdout)) {
+                    perror("Error: Could not redirect a replayed engine");
+                    exit(EXIT_FAILURE);
+                }
+            } else {
+                dup2(fds[1], STDOUT_FILENO);
+                close(fds[1]);
+            }
+            return e;
+        }
+        close(fds[1]);
+        logs[e] = fdopen(fds[0], "r");
+        if (!logs[e]) {
+            perror("Error: Could not read the output of an engine");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return NUM_ENGINES;
+}
+
+// Events start with the simulation time; the final statistics do not
+static int event_time(const char* line) {
+
+    int time;
+    char comma;
+    if (sscanf(line, "%d%c", &time, &comma) == 2 && comma == ',') {
+        return time;
+    }
+    return NO_STOP;
+}
+
+// Called by a replayed engine at the start of the step where it stops: report the clock, the
+// memory in use, the run queue and every process that has arrived but not finished, then exit
+void stop_replay(ProcessManager* pm, MemoryManager* mm, FrameManager* fm) {
+    FILE* out = state_out;
+
+    fprintf(out, "time=%d completed=%d/%d arrived=%d", pm->simulation_time, pm->completed_processes,
+        pm->num_processes, pm->next_process_index);
+    if (mm->strategy == FIRST_FIT) {
+        fprintf(out, " mem-available=%d", mm->mem_available);
+    } else if ((mm->strategy == PAGED) | (mm->strategy == VIRTUAL)) {
+        fprintf(out, " frames-in-use=%d", fm->frames_in_use);
+    }
+    fprintf(out, "\n");
+
+    // The process that ran the last quantum, and the queue it goes back to
+    int running = pm->interrupted_process_index;
+    fprintf(out, "queue=");
+    if (pm->cores) {
+        Core* core = &pm->cores->cores[0];
+        RunDeque* dq = &core->ready;
+        running = core->current;
+        for (int i = 0; i < dq->size; i++) {
+            fprintf(out, "%s%s", i ? "," : "", pm->processes[dq->arr[(dq->head + i) % dq->capacity]].name);
+        }
+    } else {
+        CircularQueue* cq = &pm->current_processes;
+        for (int i = 0; i < cq->size; i++) {
+            fprintf(out, "%s%s", i ? "," : "", pm->processes[queue_at(cq, i)].name);
+        }
+    }
+    fprintf(out, " last-run=%s\n", running == NOT_INTERRUPTED ? "none" : pm->processes[running].name);
+
+    for (int i = 0; i < pm->next_process_index; i++) {
+        if (pm->processes[i].status != FINISHED) {
+            print_process_state(out, mm, fm, &pm->processes[i]);
+        }
+    }
+    fclose(out);
+    exit(EXIT_SUCCESS);
+}
+
+static void print_process_state(FILE* out, MemoryManager* mm, FrameManager* fm, Process* process) {
+
+    fprintf(out, "%s status=%s remaining-time=%d memory=", process->name, get_status_string(process->status),
+        process->remaining_time);
+    if (!process->memory_allocated) {
+        fprintf(out, "none\n");
+    } else if (mm->strategy == FIRST_FIT && process->memory_block) {
+        fprintf(out, "%d+%d\n", process->memory_block->starting_address, process->memory_block->length);
+    } else if ((mm->strategy == PAGED) | (mm->strategy == VIRTUAL)) {
+        // Superframes are shown as their first frame and size
+        fprintf(out, "[");
+        for (int i = 0; i < process->num_frames; i++) {
+            fprintf(out, "%s%d", i ? "," : "", process->frames[i]);
+            if (i < process->num_superframes) {
+                fprintf(out, "+%d", fm->superframe_frames);
+            }
+        }
+        fprintf(out, "]\n");
+    } else {
+        fprintf(out, "allocated\n");
+    }
+}
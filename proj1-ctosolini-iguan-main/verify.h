@@ -0,0 +1,19 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+#include "process.h"
+#include "memory_allocation.h"
+#include "paged_allocation.h"
+
+#define MAX_EVENT_LINE 8192 // an eviction line lists up to every frame
+
+typedef enum {
+    ENGINE_REFERENCE, // a plain quantum-by-quantum loop, left without the optimisations under test
+    ENGINE_SINGLE_CORE, // the single-core scheduler, with its idle skipping and whole rounds
+    ENGINE_PER_CORE, // the per-core scheduler on one core, with its batching and host-thread phases
+    NUM_ENGINES
+} Engine;
+
+Engine verify_engines(ProcessManager* pm);
+void stop_replay(ProcessManager* pm, MemoryManager* mm, FrameManager* fm);
+
+#endif // VERIFY_H
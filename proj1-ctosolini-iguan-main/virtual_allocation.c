@@ -1,4 +1,5 @@
 #include "virtual_allocation.h"
+#include "numa.h"
 
 // A process can be executed if at least 4 of its pages are allocated
 
@@ -47,7 +48,7 @@ int allocate_virtual(FrameManager *fm, ProcessManager *pm, Process *process_to_a
         Process *lru_process = find_lru_process(pm, process_to_allocate);
         if (lru_process == NULL)
         {
-            perror("No suitable LRU process found for eviction.\n");
+            // Every other resident process is running on another core
             return NOT_ALLOCATED;
         }
         // Evict the frames of the LRU process
@@ -91,6 +92,7 @@ int allocate_virtual(FrameManager *fm, ProcessManager *pm, Process *process_to_a
 
 void release_frame_virtual(FrameManager *fm, int frame_index)
 {
+    count_bank_frame(fm, frame_index, NOT_ALLOCATED);
     fm->frames[frame_index].is_allocated = NOT_ALLOCATED;
     fm->frames[frame_index].page_number = NOT_IN_USE;
     fm->frames_in_use--;
@@ -124,11 +126,13 @@ int allocate_frames_virtual(FrameManager *fm, Process *process, int num_frames)
     int allocated = 0;
     for (int i = 0; i < TOTAL_FRAMES && allocated < num_frames; i++)
     {
-        if (fm->frames[i].is_allocated == NOT_ALLOCATED)
+        int f = frame_in_order(fm, process, i);
+        if (fm->frames[f].is_allocated == NOT_ALLOCATED)
         {
-            fm->frames[i].is_allocated = ALLOCATED;
-            fm->frames[i].page_number = process->frames[allocated];
-            process->frames[allocated] = i;
+            count_bank_frame(fm, f, ALLOCATED);
+            fm->frames[f].is_allocated = ALLOCATED;
+            fm->frames[f].page_number = process->frames[allocated];
+            process->frames[allocated] = f;
             allocated++;
         }
     }